@@ -0,0 +1,121 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <osmium/geom/haversine.hpp>
+#include <string>
+#include <vector>
+
+#include "angle_kernel.hpp"
+#include "synthetic_roads.hpp"
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+/// @brief Sides and vectors of the triangles at the first node after the
+/// start of a generated way, one node before and @c size nodes after it
+struct Window {
+  double dist_b;
+  std::vector<double> dist_a;
+  std::vector<double> dist_c;
+
+  double x;
+  double y;
+  double norm;
+  std::vector<double> xs;
+  std::vector<double> ys;
+  std::vector<double> norms;
+};
+
+auto generate_window(std::size_t size) -> Window {
+  ntask::bench::SyntheticRoads roads{
+      ntask::bench::RoadShape{.node_count = size + 2,
+                              .node_spacing = 5,
+                              .turn_deviation = 10,
+                              .hairpin_share = 0.01},
+      SEED};
+  const auto nodes = roads.next_way();
+  const auto &left = nodes[0].location();
+  const auto &center = nodes[1].location();
+  const auto project = [&center](const osmium::Location &location) {
+    const auto scale = std::cos(osmium::geom::deg_to_rad(center.lat()));
+    return std::pair{
+        osmium::geom::deg_to_rad(location.lon() - center.lon()) * scale *
+            osmium::geom::haversine::EARTH_RADIUS_IN_METERS,
+        osmium::geom::deg_to_rad(location.lat() - center.lat()) *
+            osmium::geom::haversine::EARTH_RADIUS_IN_METERS};
+  };
+
+  Window window{};
+  window.dist_b = osmium::geom::haversine::distance(left, center);
+  std::tie(window.x, window.y) = project(left);
+  window.norm = std::hypot(window.x, window.y);
+  for (std::size_t node = 2; node < nodes.size(); ++node) {
+    const auto &right = nodes[node].location();
+    window.dist_a.push_back(osmium::geom::haversine::distance(center, right));
+    window.dist_c.push_back(osmium::geom::haversine::distance(left, right));
+    const auto [x, y] = project(right);
+    window.xs.push_back(x);
+    window.ys.push_back(y);
+    window.norms.push_back(std::hypot(x, y));
+  }
+  return window;
+}
+
+auto find_kernel(benchmark::State &state, const std::string &name)
+    -> const ntask::AngleKernel * {
+  const auto *kernel = ntask::AngleKernel::find(name);
+  if (kernel == nullptr) {
+    state.SkipWithError(("No " + name + " kernel on this CPU").c_str());
+  }
+  return kernel;
+}
+
+/// @brief Law of cosines over a window, by the number of nodes after
+void max_cosine_by_sides(benchmark::State &state, const std::string &name) {
+  const auto *kernel = find_kernel(state, name);
+  if (kernel == nullptr) {
+    return;
+  }
+  const auto window = generate_window(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kernel->max_cosine_by_sides(
+        window.dist_b, window.dist_a, window.dist_c));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(max_cosine_by_sides, scalar, "scalar")
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+BENCHMARK_CAPTURE(max_cosine_by_sides, avx2, "avx2")
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+BENCHMARK_CAPTURE(max_cosine_by_sides, avx512, "avx512")
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+/// @brief Dot products over a window, by the number of nodes after
+void max_cosine_by_vectors(benchmark::State &state, const std::string &name) {
+  const auto *kernel = find_kernel(state, name);
+  if (kernel == nullptr) {
+    return;
+  }
+  const auto window = generate_window(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        kernel->max_cosine_by_vectors(window.x, window.y, window.norm,
+                                      window.xs, window.ys, window.norms));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK_CAPTURE(max_cosine_by_vectors, scalar, "scalar")
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+BENCHMARK_CAPTURE(max_cosine_by_vectors, avx2, "avx2")
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+BENCHMARK_CAPTURE(max_cosine_by_vectors, avx512, "avx512")
+    ->RangeMultiplier(4)
+    ->Range(4, 256);
+
+}  // namespace
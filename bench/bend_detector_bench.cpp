@@ -0,0 +1,236 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "synthetic_roads.hpp"
+
+using ntask::BendDetector;
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+/// @brief Ways scanned in turn, enough to not only measure one way hot in
+/// cache
+constexpr std::size_t WAY_COUNT = 256;
+
+constexpr std::size_t NODES_PER_WAY = 200;
+
+/// @brief Thresholds of the default configuration
+constexpr double DISTANCE_THRESHOLD = 50;
+constexpr double ANGLE_THRESHOLD = 135;
+
+auto generate_ways(const ntask::bench::RoadShape &shape)
+    -> std::vector<std::vector<osmium::NodeRef>> {
+  ntask::bench::SyntheticRoads roads{shape, SEED};
+  std::vector<std::vector<osmium::NodeRef>> ways;
+  for (std::size_t way = 0; way < WAY_COUNT; ++way) {
+    ways.push_back(roads.next_way());
+  }
+  return ways;
+}
+
+/// @brief Window search and angle evaluation of whole ways, by node spacing
+/// in meter (the node density) and the deviation of turns in degree (the
+/// curvature)
+void window_search(benchmark::State &state,
+                   BendDetector::DistanceModel distance_model) {
+  const auto ways = generate_ways(ntask::bench::RoadShape{
+      .node_count = NODES_PER_WAY,
+      .node_spacing = static_cast<double>(state.range(0)),
+      .turn_deviation = static_cast<double>(state.range(1)),
+      .hairpin_share = 0.01});
+  BendDetector detector{DISTANCE_THRESHOLD, ANGLE_THRESHOLD, distance_model};
+  std::vector<osmium::NodeRef> dangerous_bends;
+  std::size_t way = 0;
+  for (auto _ : state) {
+    dangerous_bends.clear();
+    detector.detect(ways[way], dangerous_bends);
+    benchmark::DoNotOptimize(dangerous_bends.data());
+    way = (way + 1) % ways.size();
+  }
+
+  const auto &counters = detector.get_counters();
+  const auto node_count = static_cast<double>(counters.way_count) *
+                          static_cast<double>(NODES_PER_WAY);
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(NODES_PER_WAY));
+  state.counters["distances_per_node"] =
+      static_cast<double>(counters.distance_count) / node_count;
+  state.counters["angles_per_node"] =
+      static_cast<double>(counters.angle_count) / node_count;
+  state.counters["skipped_way_share"] =
+      static_cast<double>(counters.skipped_way_count) /
+      static_cast<double>(counters.way_count);
+}
+BENCHMARK_CAPTURE(window_search, haversine,
+                  BendDetector::DistanceModel::haversine)
+    ->ArgsProduct({{2, 5, 15, 50}, {2, 10, 30}})
+    ->ArgNames({"spacing", "turn"});
+BENCHMARK_CAPTURE(window_search, planar, BendDetector::DistanceModel::planar)
+    ->ArgsProduct({{2, 5, 15, 50}, {2, 10, 30}})
+    ->ArgNames({"spacing", "turn"});
+
+/// @brief Ways without hairpins like most trunk and primary roads, where the
+/// curvature of many ways proves that they have no bend, by the deviation of
+/// turns in degree
+void straight_window_search(benchmark::State &state) {
+  const auto ways = generate_ways(ntask::bench::RoadShape{
+      .node_count = NODES_PER_WAY,
+      .node_spacing = 15,
+      .turn_deviation = static_cast<double>(state.range(0)),
+      .hairpin_share = 0});
+  BendDetector detector{DISTANCE_THRESHOLD, ANGLE_THRESHOLD};
+  std::vector<osmium::NodeRef> dangerous_bends;
+  std::size_t way = 0;
+  for (auto _ : state) {
+    dangerous_bends.clear();
+    detector.detect(ways[way], dangerous_bends);
+    benchmark::DoNotOptimize(dangerous_bends.data());
+    way = (way + 1) % ways.size();
+  }
+  const auto &counters = detector.get_counters();
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(NODES_PER_WAY));
+  state.counters["skipped_way_share"] =
+      static_cast<double>(counters.skipped_way_count) /
+      static_cast<double>(counters.way_count);
+}
+BENCHMARK(straight_window_search)->Arg(1)->Arg(2)->Arg(5)->ArgName("turn");
+
+/// @brief Several profiles in one scan, by the number of profiles with
+/// distance thresholds spread up to twice the default
+void window_search_profiles(benchmark::State &state) {
+  const auto ways = generate_ways(ntask::bench::RoadShape{});
+  const auto profile_count = static_cast<std::size_t>(state.range(0));
+  std::vector<BendDetector::Thresholds> profiles;
+  for (std::size_t profile = 0; profile < profile_count; ++profile) {
+    profiles.push_back(BendDetector::Thresholds{
+        .distance_threshold =
+            DISTANCE_THRESHOLD * static_cast<double>(profile_count + profile) /
+            static_cast<double>(profile_count),
+        .angle_threshold = ANGLE_THRESHOLD});
+  }
+  BendDetector detector{profiles, BendDetector::DistanceModel::haversine};
+  const auto all_profiles = (ntask::ProfileMask{1} << profile_count) - 1;
+  std::vector<BendDetector::Bend> dangerous_bends;
+  std::size_t way = 0;
+  for (auto _ : state) {
+    dangerous_bends.clear();
+    detector.detect(ways[way], all_profiles, dangerous_bends);
+    benchmark::DoNotOptimize(dangerous_bends.data());
+    way = (way + 1) % ways.size();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(NODES_PER_WAY));
+}
+BENCHMARK(window_search_profiles)->Arg(1)->Arg(4)->Arg(16)->ArgName("profiles");
+
+/// @brief Consecutive nodes of a way found as dangerous bends, the first and
+/// the last ID
+using BendRun = std::pair<osmium::object_id_type, osmium::object_id_type>;
+
+/// @return Dangerous bends of all @p ways found by @p detector, the runs of
+/// consecutive nodes each
+auto detect_runs(BendDetector &detector,
+                 const std::vector<std::vector<osmium::NodeRef>> &ways)
+    -> std::vector<BendRun> {
+  std::vector<BendRun> runs;
+  std::vector<BendDetector::Bend> dangerous_bends;
+  for (const auto &way : ways) {
+    dangerous_bends.clear();
+    detector.detect(way, 1, dangerous_bends);
+    // Found in way order, the IDs of a generated way count up
+    for (std::size_t bend = 0; bend < dangerous_bends.size(); ++bend) {
+      const auto id = dangerous_bends[bend].node.ref();
+      if (bend > 0 && runs.back().second + 1 == id) {
+        runs.back().second = id;
+      } else {
+        runs.emplace_back(id, id);
+      }
+    }
+  }
+  return runs;
+}
+
+/// @brief Scan of densely traced ways (a node every 1.5 m on average)
+/// simplified first, by the tolerance in decimeter.
+///
+/// A scan of every node finds all nodes along a tight curve, the simplified
+/// scan only the kept ones, so results compare by bend: recall is the share
+/// of the runs of nodes found by a scan of every node that contain a node
+/// found after simplification, precision the share of those nodes within a
+/// run.
+void simplified_window_search(benchmark::State &state) {
+  constexpr double DECIMETER = 0.1;
+  const auto ways = generate_ways(ntask::bench::RoadShape{
+      .node_count = NODES_PER_WAY,
+      .node_spacing = 1.5,
+      .turn_deviation = 3,
+      .hairpin_share = 0.01});
+  const std::vector<BendDetector::Thresholds> profiles{BendDetector::Thresholds{
+      .distance_threshold = DISTANCE_THRESHOLD,
+      .angle_threshold = ANGLE_THRESHOLD}};
+  BendDetector detector{profiles, BendDetector::DistanceModel::haversine,
+                        static_cast<double>(state.range(0)) * DECIMETER};
+  std::vector<BendDetector::Bend> dangerous_bends;
+  std::size_t way = 0;
+  for (auto _ : state) {
+    dangerous_bends.clear();
+    detector.detect(ways[way], 1, dangerous_bends);
+    benchmark::DoNotOptimize(dangerous_bends.data());
+    way = (way + 1) % ways.size();
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(NODES_PER_WAY));
+  const auto &counters = detector.get_counters();
+  state.counters["kept_node_share"] =
+      1 - (static_cast<double>(counters.simplified_node_count) /
+           (static_cast<double>(counters.way_count) *
+            static_cast<double>(NODES_PER_WAY)));
+
+  BendDetector full_detector{profiles, BendDetector::DistanceModel::haversine};
+  const auto full_runs = detect_runs(full_detector, ways);
+  std::size_t simplified_count = 0;
+  std::size_t matched_count = 0;
+  std::vector<bool> recalled(full_runs.size());
+  for (const auto &run : detect_runs(detector, ways)) {
+    for (auto id = run.first; id <= run.second; ++id) {
+      ++simplified_count;
+      // First run ending at or after the node
+      const auto full_run = std::lower_bound(
+          full_runs.begin(), full_runs.end(), id,
+          [](const BendRun &lhs, osmium::object_id_type rhs) {
+            return lhs.second < rhs;
+          });
+      if (full_run != full_runs.end() && full_run->first <= id) {
+        ++matched_count;
+        recalled[static_cast<std::size_t>(full_run - full_runs.begin())] =
+            true;
+      }
+    }
+  }
+  const auto recalled_count =
+      std::count(recalled.begin(), recalled.end(), true);
+  state.counters["recall"] =
+      full_runs.empty() ? 1
+                        : static_cast<double>(recalled_count) /
+                              static_cast<double>(full_runs.size());
+  state.counters["precision"] =
+      simplified_count == 0 ? 1
+                            : static_cast<double>(matched_count) /
+                                  static_cast<double>(simplified_count);
+}
+BENCHMARK(simplified_window_search)
+    ->Arg(0)
+    ->Arg(2)
+    ->Arg(5)
+    ->Arg(10)
+    ->Arg(20)
+    ->Arg(50)
+    ->ArgName("tolerance_dm");
+
+}  // namespace
@@ -0,0 +1,221 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <filesystem>
+#include <numbers>
+#include <string>
+#include <vector>
+
+#include "bend_index.hpp"
+#include "bend_index_writer.hpp"
+#include "bend_table.hpp"
+#include "bend_table_writer.hpp"
+#include "synthetic_roads.hpp"
+
+using ntask::BendIndex;
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+/// @brief Bends of a generated way, dense like the bends of a winding road
+constexpr std::size_t BENDS_PER_WAY = 200;
+
+/// @brief Query points taken in turn, spread over the bends
+constexpr std::size_t QUERY_COUNT = 1024;
+
+constexpr double QUERY_RADIUS = 500;
+
+/// @brief Zoom level of the tiles queried, about 2.4 km wide at the equator
+constexpr unsigned TILE_ZOOM = 14;
+
+/// @return @p count generated bends along winding roads
+auto generate_bends(std::size_t count)
+    -> std::vector<ntask::BendDetector::Bend> {
+  ntask::bench::SyntheticRoads roads{
+      ntask::bench::RoadShape{.node_count = BENDS_PER_WAY,
+                              .node_spacing = 15,
+                              .turn_deviation = 10,
+                              .hairpin_share = 0},
+      SEED};
+  std::vector<ntask::BendDetector::Bend> bends;
+  for (osmium::object_id_type way = 1; bends.size() < count; ++way) {
+    for (const auto &node : roads.next_way()) {
+      bends.push_back(ntask::BendDetector::Bend{
+          .node = node, .profile = 0, .min_angle = 90, .way_id = way});
+    }
+  }
+  bends.resize(count);
+  return bends;
+}
+
+/// @brief Write @p bends to a temporary file with a @c BendIndexWriter or a
+/// @c BendTableWriter
+template <typename TWriter>
+auto write_bends(const std::vector<ntask::BendDetector::Bend> &bends,
+                 const std::string &name) -> std::filesystem::path {
+  const auto path =
+      std::filesystem::temp_directory_path() /
+      ("ntask_bench_" + name + "_" + std::to_string(bends.size()));
+  TWriter writer{path.string(), false};
+  for (const auto &bend : bends) {
+    writer.write(bend);
+  }
+  writer.close();
+  return path;
+}
+
+/// @return Locations of bends spread over all roads
+auto get_query_points(const std::vector<ntask::BendDetector::Bend> &bends)
+    -> std::vector<osmium::Location> {
+  // A prime step does not hit the same place of every road
+  constexpr std::size_t STEP = 7919;
+  std::vector<osmium::Location> points;
+  for (std::size_t query = 0; query < QUERY_COUNT; ++query) {
+    points.push_back(bends[(query * STEP) % bends.size()].node.location());
+  }
+  return points;
+}
+
+/// @return Box of the web mercator tile containing a point
+auto get_tile(const osmium::Location &point) -> ntask::BendBox {
+  constexpr double DEGREE = std::numbers::pi / 180;
+  constexpr double FULL_TURN = 360;
+  constexpr double HALF_TURN = 180;
+  constexpr auto TILES = static_cast<double>(1U << TILE_ZOOM);
+  const auto x = std::floor((point.lon() + HALF_TURN) / FULL_TURN * TILES);
+  const auto mercator_y = std::asinh(std::tan(point.lat() * DEGREE));
+  const auto y = std::floor((1 - (mercator_y / std::numbers::pi)) / 2 * TILES);
+  const auto to_lat = [](double tile_y) {
+    const auto tile_mercator_y = std::numbers::pi * (1 - (2 * tile_y / TILES));
+    return std::atan(std::sinh(tile_mercator_y)) / DEGREE;
+  };
+  return ntask::BendBox::from_degrees(
+      (x / TILES * FULL_TURN) - HALF_TURN, to_lat(y + 1),
+      ((x + 1) / TILES * FULL_TURN) - HALF_TURN, to_lat(y));
+}
+
+/// @brief Build an index over the bends, by the number of bends
+void build_bend_index(benchmark::State &state) {
+  const auto bends = generate_bends(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    std::filesystem::remove(
+        write_bends<ntask::BendIndexWriter>(bends, "index"));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(build_bend_index)
+    ->RangeMultiplier(10)
+    ->Range(10000, 1000000)
+    ->Unit(benchmark::kMillisecond);
+
+/// @brief Bends within 500 m of a point, by the number of bends in the index
+void query_radius(benchmark::State &state) {
+  const auto bends = generate_bends(static_cast<std::size_t>(state.range(0)));
+  const auto path = write_bends<ntask::BendIndexWriter>(bends, "index");
+  const BendIndex index{path.string()};
+  const auto points = get_query_points(bends);
+  std::size_t query = 0;
+  std::size_t result_count = 0;
+  for (auto _ : state) {
+    const auto &point = points[query];
+    index.query_radius(point.lon(), point.lat(), QUERY_RADIUS,
+                       [&result_count](const ntask::BendRecord &) {
+                         ++result_count;
+                       });
+    query = (query + 1) % points.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["results_per_query"] =
+      static_cast<double>(result_count) /
+      static_cast<double>(state.iterations());
+  std::filesystem::remove(path);
+}
+BENCHMARK(query_radius)->RangeMultiplier(10)->Range(10000, 1000000);
+
+/// @brief Bends in the zoom 14 tile of a point, by the number of bends in
+/// the index
+void query_tile(benchmark::State &state) {
+  const auto bends = generate_bends(static_cast<std::size_t>(state.range(0)));
+  const auto path = write_bends<ntask::BendIndexWriter>(bends, "index");
+  const BendIndex index{path.string()};
+  std::vector<ntask::BendBox> tiles;
+  for (const auto &point : get_query_points(bends)) {
+    tiles.push_back(get_tile(point));
+  }
+  std::size_t query = 0;
+  std::size_t result_count = 0;
+  for (auto _ : state) {
+    index.query(tiles[query], [&result_count](const ntask::BendRecord &) {
+      ++result_count;
+    });
+    query = (query + 1) % tiles.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["results_per_query"] =
+      static_cast<double>(result_count) /
+      static_cast<double>(state.iterations());
+  std::filesystem::remove(path);
+}
+BENCHMARK(query_tile)->RangeMultiplier(10)->Range(10000, 1000000);
+
+/// @brief Bends along a route, by the number of bends in the index. The
+/// routes follow the generated roads, 200 points over about 3 km, and find
+/// the bends of their road and of roads crossing it.
+void query_corridor(benchmark::State &state) {
+  constexpr double CORRIDOR_WIDTH = 25;
+  const auto bends = generate_bends(static_cast<std::size_t>(state.range(0)));
+  const auto path = write_bends<ntask::BendIndexWriter>(bends, "index");
+  const BendIndex index{path.string()};
+  std::vector<std::vector<ntask::RoutePoint>> routes;
+  for (std::size_t begin = 0; begin + BENDS_PER_WAY <= bends.size();
+       begin += BENDS_PER_WAY) {
+    auto &route = routes.emplace_back();
+    for (auto bend = begin; bend < begin + BENDS_PER_WAY; ++bend) {
+      const auto location = bends[bend].node.location();
+      route.push_back(
+          ntask::RoutePoint{.lon = location.lon(), .lat = location.lat()});
+    }
+  }
+  std::size_t route = 0;
+  std::size_t result_count = 0;
+  for (auto _ : state) {
+    result_count += index.query_corridor(routes[route], CORRIDOR_WIDTH).size();
+    route = (route + 1) % routes.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["results_per_query"] =
+      static_cast<double>(result_count) /
+      static_cast<double>(state.iterations());
+  std::filesystem::remove(path);
+}
+BENCHMARK(query_corridor)->RangeMultiplier(10)->Range(10000, 1000000);
+
+/// @brief Bends within 500 m of a point by a scan of a bend table, the
+/// baseline of @c query_radius
+void query_radius_scan(benchmark::State &state) {
+  const auto bends = generate_bends(static_cast<std::size_t>(state.range(0)));
+  const auto path = write_bends<ntask::BendTableWriter>(bends, "table");
+  const ntask::BendTable table{path.string()};
+  const auto points = get_query_points(bends);
+  std::size_t query = 0;
+  std::size_t result_count = 0;
+  for (auto _ : state) {
+    const auto &point = points[query];
+    for (const auto &record : table.records()) {
+      if (BendIndex::get_distance(point.lon(), point.lat(), record.get_lon(),
+                                  record.get_lat()) <= QUERY_RADIUS) {
+        ++result_count;
+      }
+    }
+    query = (query + 1) % points.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["results_per_query"] =
+      static_cast<double>(result_count) /
+      static_cast<double>(state.iterations());
+  std::filesystem::remove(path);
+}
+BENCHMARK(query_radius_scan)->RangeMultiplier(10)->Range(10000, 1000000);
+
+}  // namespace
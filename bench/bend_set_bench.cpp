@@ -0,0 +1,100 @@
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "bend_set.hpp"
+#include "synthetic_roads.hpp"
+
+using ntask::BendDetector;
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+/// @brief Bends added per iteration
+constexpr std::size_t BEND_COUNT = std::size_t{1} << 18U;
+
+/// @return @c BEND_COUNT bends of different ways, @p duplicate_percent of
+/// them at a node found before
+auto generate_bends(std::size_t duplicate_percent)
+    -> std::vector<BendDetector::Bend> {
+  constexpr std::size_t PERCENT = 100;
+  // Every distinct node is found equally often, a prime step spreads its
+  // duplicates over the whole run
+  constexpr std::size_t STEP = 1000003;
+  const auto distinct_count =
+      BEND_COUNT * (PERCENT - duplicate_percent) / PERCENT;
+  ntask::bench::SyntheticRoads roads{
+      ntask::bench::RoadShape{.node_count = distinct_count,
+                              .node_spacing = 15,
+                              .turn_deviation = 10,
+                              .hairpin_share = 0},
+      SEED};
+  const auto nodes = roads.next_way();
+  std::vector<BendDetector::Bend> bends;
+  for (std::size_t bend = 0; bend < BEND_COUNT; ++bend) {
+    bends.push_back(BendDetector::Bend{
+        .node = nodes[(bend * STEP) % distinct_count],
+        .profile = 0,
+        .min_angle = 90,
+        .way_id = static_cast<osmium::object_id_type>(bend)});
+  }
+  return bends;
+}
+
+/// @brief Bends kept in a @c BendSet until the end of a run with
+/// `deduplicate`, by the percentage of duplicate bends
+void bend_set(benchmark::State &state) {
+  const auto bends =
+      generate_bends(static_cast<std::size_t>(state.range(0)));
+  std::size_t used_memory = 0;
+  for (auto _ : state) {
+    ntask::BendSet set;
+    for (const auto &bend : bends) {
+      set.add(bend);
+    }
+    used_memory = set.used_memory();
+    benchmark::DoNotOptimize(set.get_entries().data());
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(BEND_COUNT));
+  state.counters["bytes"] = static_cast<double>(used_memory);
+  state.counters["bytes_per_bend"] =
+      static_cast<double>(used_memory) / static_cast<double>(BEND_COUNT);
+}
+BENCHMARK(bend_set)
+    ->Arg(0)
+    ->Arg(25)
+    ->Arg(50)
+    ->Arg(75)
+    ->ArgName("duplicates");
+
+/// @brief The same bends kept with every duplicate in a vector, as without
+/// a set, for comparing the memory with @c bend_set
+void bend_vector(benchmark::State &state) {
+  const auto bends =
+      generate_bends(static_cast<std::size_t>(state.range(0)));
+  std::size_t used_memory = 0;
+  for (auto _ : state) {
+    std::vector<BendDetector::Bend> vector;
+    for (const auto &bend : bends) {
+      vector.push_back(bend);
+    }
+    used_memory = vector.capacity() * sizeof(BendDetector::Bend);
+    benchmark::DoNotOptimize(vector.data());
+  }
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<std::int64_t>(BEND_COUNT));
+  state.counters["bytes"] = static_cast<double>(used_memory);
+  state.counters["bytes_per_bend"] =
+      static_cast<double>(used_memory) / static_cast<double>(BEND_COUNT);
+}
+BENCHMARK(bend_vector)
+    ->Arg(0)
+    ->Arg(25)
+    ->Arg(50)
+    ->Arg(75)
+    ->ArgName("duplicates");
+
+}  // namespace
@@ -0,0 +1,50 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <vector>
+
+#include "json_writer.hpp"
+#include "synthetic_roads.hpp"
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+constexpr std::size_t NODE_COUNT = 4096;
+
+/// @brief Records written to a temporary file, compact (1) or indented (0),
+/// with a `way_count` field as with deduplication or without
+void json_writer_write(benchmark::State &state) {
+  ntask::bench::SyntheticRoads roads{
+      ntask::bench::RoadShape{.node_count = NODE_COUNT,
+                              .node_spacing = 15,
+                              .turn_deviation = 10,
+                              .hairpin_share = 0},
+      SEED};
+  const auto nodes = roads.next_way();
+  const auto path =
+      std::filesystem::temp_directory_path() / "ntask_bench_output.json";
+  const auto with_way_count = state.range(1) != 0;
+  {
+    ntask::JsonWriter writer{path.string(), state.range(0) != 0};
+    std::size_t node = 0;
+    for (auto _ : state) {
+      if (with_way_count) {
+        writer.write(nodes[node], 1);
+      } else {
+        writer.write(nodes[node]);
+      }
+      node = (node + 1) % nodes.size();
+    }
+    writer.close();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(
+      static_cast<std::int64_t>(std::filesystem::file_size(path)));
+  std::filesystem::remove(path);
+}
+BENCHMARK(json_writer_write)
+    ->ArgsProduct({{0, 1}, {0, 1}})
+    ->ArgNames({"compact", "way_count"});
+
+}  // namespace
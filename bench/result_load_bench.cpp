@@ -0,0 +1,87 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "bend_table.hpp"
+#include "bend_table_writer.hpp"
+#include "json_writer.hpp"
+#include "nlohmann/json.hpp"
+#include "synthetic_roads.hpp"
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+/// @brief Output format of the results loaded
+enum class Format { json, compact_json, binary };
+
+/// @brief Write @p count generated bends in @p format to a temporary file
+auto write_results(Format format, std::size_t count)
+    -> std::filesystem::path {
+  ntask::bench::SyntheticRoads roads{
+      ntask::bench::RoadShape{.node_count = count,
+                              .node_spacing = 15,
+                              .turn_deviation = 10,
+                              .hairpin_share = 0},
+      SEED};
+  const auto nodes = roads.next_way();
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("ntask_bench_results_" +
+                     std::to_string(static_cast<int>(format)) + "_" +
+                     std::to_string(count));
+  if (format == Format::binary) {
+    ntask::BendTableWriter writer{path.string(), false};
+    for (const auto &node : nodes) {
+      writer.write(ntask::BendDetector::Bend{
+          .node = node, .profile = 0, .min_angle = 90, .way_id = 1});
+    }
+    writer.close();
+  } else {
+    ntask::JsonWriter writer{path.string(), format == Format::compact_json};
+    for (const auto &node : nodes) {
+      writer.write(node);
+    }
+    writer.close();
+  }
+  return path;
+}
+
+/// @brief Cold start of a consumer: open the results and read the location
+/// of every bend, by the number of bends
+void load_results(benchmark::State &state, Format format) {
+  const auto path =
+      write_results(format, static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    double lat_sum = 0;
+    if (format == Format::binary) {
+      const ntask::BendTable table{path.string()};
+      for (const auto &record : table.records()) {
+        lat_sum += record.get_lat();
+      }
+    } else {
+      std::ifstream file{path};
+      for (const auto &record : nlohmann::json::parse(file)) {
+        lat_sum += record["location"]["lat"].get<double>();
+      }
+    }
+    benchmark::DoNotOptimize(lat_sum);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(
+      state.iterations() *
+      static_cast<std::int64_t>(std::filesystem::file_size(path)));
+  std::filesystem::remove(path);
+}
+BENCHMARK_CAPTURE(load_results, json, Format::json)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000);
+BENCHMARK_CAPTURE(load_results, compact_json, Format::compact_json)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000);
+BENCHMARK_CAPTURE(load_results, binary, Format::binary)
+    ->RangeMultiplier(10)
+    ->Range(1000, 100000);
+
+}  // namespace
@@ -0,0 +1,140 @@
+#include "synthetic_roads.hpp"
+
+#include <array>
+#include <cmath>
+#include <osmium/builder/osm_object_builder.hpp>
+#include <osmium/geom/coordinates.hpp>
+#include <osmium/geom/haversine.hpp>
+
+using ntask::bench::SyntheticRoads;
+
+namespace {
+
+/// @brief Value of `highway` with its weight
+struct HighwayValue {
+  const char *value;
+  unsigned weight;
+};
+
+/// @brief Roughly the mix of highway values of a European extract
+constexpr std::array HIGHWAY_VALUES{
+    HighwayValue{.value = "residential", .weight = 30},
+    HighwayValue{.value = "service", .weight = 20},
+    HighwayValue{.value = "track", .weight = 12},
+    HighwayValue{.value = "footway", .weight = 10},
+    HighwayValue{.value = "unclassified", .weight = 8},
+    HighwayValue{.value = "tertiary", .weight = 6},
+    HighwayValue{.value = "secondary", .weight = 5},
+    HighwayValue{.value = "primary", .weight = 4},
+    HighwayValue{.value = "path", .weight = 3},
+    HighwayValue{.value = "trunk", .weight = 1},
+    HighwayValue{.value = "motorway", .weight = 1}};
+
+/// @brief Tag added to a way with a probability
+struct OptionalTag {
+  const char *key;
+  const char *value;
+  double share;
+};
+
+constexpr std::array OPTIONAL_TAGS{
+    OptionalTag{.key = "name", .value = "Main Street", .share = 0.5},
+    OptionalTag{.key = "surface", .value = "asphalt", .share = 0.4},
+    OptionalTag{.key = "maxspeed", .value = "50", .share = 0.3},
+    OptionalTag{.key = "lit", .value = "yes", .share = 0.2},
+    OptionalTag{.key = "lanes", .value = "2", .share = 0.2},
+    OptionalTag{.key = "oneway", .value = "yes", .share = 0.15},
+    OptionalTag{.key = "service", .value = "driveway", .share = 0.1},
+    OptionalTag{.key = "ref", .value = "B 27", .share = 0.05},
+    OptionalTag{.key = "junction", .value = "roundabout", .share = 0.02}};
+
+constexpr double MAX_START_LATITUDE = 60;
+constexpr double MAX_START_LONGITUDE = 180;
+constexpr double HAIRPIN_TURN = 150;
+
+}  // namespace
+
+SyntheticRoads::SyntheticRoads(const RoadShape &shape, std::uint64_t seed)
+    : shape(shape), random(seed) {}
+
+auto SyntheticRoads::next_way() -> std::vector<osmium::NodeRef> {
+  auto latitude = ((2 * uniform()) - 1) * MAX_START_LATITUDE;
+  auto longitude = ((2 * uniform()) - 1) * MAX_START_LONGITUDE;
+  auto heading = 2 * osmium::geom::PI * uniform();
+
+  std::vector<osmium::NodeRef> nodes;
+  nodes.reserve(shape.node_count);
+  for (std::size_t node = 0; node < shape.node_count; ++node) {
+    nodes.emplace_back(next_node_id++, osmium::Location{longitude, latitude});
+
+    auto turn = normal() * shape.turn_deviation;
+    if (uniform() < shape.hairpin_share) {
+      turn += uniform() < 0.5 ? HAIRPIN_TURN : -HAIRPIN_TURN;
+    }
+    heading += osmium::geom::deg_to_rad(turn);
+    const auto step = shape.node_spacing * (0.5 + uniform()) /
+                      osmium::geom::haversine::EARTH_RADIUS_IN_METERS;
+    latitude += osmium::geom::rad_to_deg(step * std::cos(heading));
+    longitude += osmium::geom::rad_to_deg(
+        step * std::sin(heading) /
+        std::cos(osmium::geom::deg_to_rad(latitude)));
+  }
+  return nodes;
+}
+
+auto SyntheticRoads::next_tags() -> Tags {
+  unsigned total_weight = 0;
+  for (const auto &highway : HIGHWAY_VALUES) {
+    total_weight += highway.weight;
+  }
+  auto pick = uniform() * total_weight;
+  const char *highway_value = HIGHWAY_VALUES.back().value;
+  for (const auto &highway : HIGHWAY_VALUES) {
+    if (pick < highway.weight) {
+      highway_value = highway.value;
+      break;
+    }
+    pick -= highway.weight;
+  }
+
+  Tags tags{{"highway", highway_value}};
+  for (const auto &tag : OPTIONAL_TAGS) {
+    if (uniform() < tag.share) {
+      tags.emplace_back(tag.key, tag.value);
+    }
+  }
+  return tags;
+}
+
+auto SyntheticRoads::uniform() -> double {
+  constexpr unsigned MANTISSA_BITS = 53;
+  return static_cast<double>(random() >> (64U - MANTISSA_BITS)) /
+         static_cast<double>(std::uint64_t{1} << MANTISSA_BITS);
+}
+
+auto SyntheticRoads::normal() -> double {
+  // Box-Muller transform, 1 - uniform() is never 0
+  return std::sqrt(-2 * std::log(1 - uniform())) *
+         std::cos(2 * osmium::geom::PI * uniform());
+}
+
+void ntask::bench::add_way(osmium::memory::Buffer &buffer,
+                           osmium::object_id_type id,
+                           std::span<const osmium::NodeRef> nodes,
+                           const Tags &tags) {
+  {
+    osmium::builder::WayBuilder way_builder{buffer};
+    way_builder.set_id(id);
+    {
+      osmium::builder::WayNodeListBuilder node_builder{way_builder};
+      for (const auto &node : nodes) {
+        node_builder.add_node_ref(node);
+      }
+    }
+    osmium::builder::TagListBuilder tag_builder{way_builder};
+    for (const auto &[key, value] : tags) {
+      tag_builder.add_tag(key, value);
+    }
+  }
+  buffer.commit();
+}
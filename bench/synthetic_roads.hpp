@@ -0,0 +1,71 @@
+#ifndef NTASK_BENCH_SYNTHETIC_ROADS_HPP
+#define NTASK_BENCH_SYNTHETIC_ROADS_HPP
+
+#include <cstdint>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/types.hpp>
+#include <random>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ntask::bench {
+
+/// @brief Tags of a generated way in order
+using Tags = std::vector<std::pair<std::string, std::string>>;
+
+/// @brief Shape of generated roads
+struct RoadShape {
+  /// @brief Nodes per way
+  std::size_t node_count = 200;
+
+  /// @brief Mean distance between consecutive nodes in meter, steps are
+  /// uniform between half and one and a half of it
+  double node_spacing = 15;
+
+  /// @brief Standard deviation of the change of heading at a node in degree,
+  /// the curvature of the road
+  double turn_deviation = 10;
+
+  /// @brief Share of nodes with a hairpin turn of 150 degree
+  double hairpin_share = 0.01;
+};
+
+/// @brief Generates random roads with a given shape and realistic tags.
+///
+/// Each way is a random walk from a random start, its heading turning by a
+/// normally distributed angle at every node. The sequence only depends on the
+/// seed: numbers are derived from the bits of `std::mt19937_64` without the
+/// standard distributions, whose results differ between standard libraries.
+class SyntheticRoads {
+ public:
+  SyntheticRoads(const RoadShape &shape, std::uint64_t seed);
+
+  /// @return Nodes of the next way, with new IDs counting up from 1
+  auto next_way() -> std::vector<osmium::NodeRef>;
+
+  /// @return Tags of the next way, a `highway` tag as common in OSM data and
+  /// a few other common tags
+  auto next_tags() -> Tags;
+
+ private:
+  /// @return Uniform in [0, 1)
+  auto uniform() -> double;
+
+  /// @return Standard normal distributed
+  auto normal() -> double;
+
+  RoadShape shape;
+  std::mt19937_64 random;
+  osmium::object_id_type next_node_id = 1;
+};
+
+/// @brief Add a way to @p buffer and commit it
+void add_way(osmium::memory::Buffer &buffer, osmium::object_id_type id,
+             std::span<const osmium::NodeRef> nodes, const Tags &tags);
+
+}  // namespace ntask::bench
+
+#endif
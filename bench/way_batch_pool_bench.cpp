@@ -0,0 +1,83 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "synthetic_roads.hpp"
+#include "way_batch_pool.hpp"
+
+using ntask::BendDetector;
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+/// @brief Ways scanned per iteration
+constexpr std::size_t WAY_COUNT = 1024;
+
+/// @brief Ways per batch, far fewer nodes than a batch of
+/// @c DangerousBendHandler so that the 64 batches keep many workers busy
+constexpr std::size_t BATCH_WAY_COUNT = 16;
+
+/// @brief Thresholds of the default configuration
+constexpr double DISTANCE_THRESHOLD = 50;
+constexpr double ANGLE_THRESHOLD = 135;
+
+/// @brief Scan of synthetic ways by a pool of workers as in the default mode,
+/// by the number of threads. Items per second against a single thread give
+/// the scaling.
+void way_batch_pool(benchmark::State &state) {
+  ntask::bench::SyntheticRoads roads{ntask::bench::RoadShape{}, SEED};
+  std::vector<std::vector<osmium::NodeRef>> ways;
+  std::int64_t node_count = 0;
+  for (std::size_t way = 0; way < WAY_COUNT; ++way) {
+    ways.push_back(roads.next_way());
+    node_count += static_cast<std::int64_t>(ways.back().size());
+  }
+  const BendDetector detector{DISTANCE_THRESHOLD, ANGLE_THRESHOLD};
+  const auto thread_count = static_cast<std::size_t>(state.range(0));
+
+  std::size_t bend_count = 0;
+  for (auto _ : state) {
+    ntask::WayBatchPool pool{detector, thread_count};
+    for (std::size_t first = 0; first < ways.size();
+         first += BATCH_WAY_COUNT) {
+      ntask::WayBatch batch;
+      for (auto way = first;
+           way < std::min(first + BATCH_WAY_COUNT, ways.size()); ++way) {
+        batch.ways.emplace_back(ways[way]);
+        batch.profiles.push_back(1);
+        batch.way_ids.push_back(static_cast<osmium::object_id_type>(way));
+      }
+      pool.submit(std::move(batch));
+    }
+    bend_count = 0;
+    for (const auto &batch_bends : pool.finish()) {
+      bend_count += batch_bends.size();
+    }
+    benchmark::DoNotOptimize(bend_count);
+  }
+  state.SetItemsProcessed(state.iterations() * node_count);
+  state.counters["bends"] = static_cast<double>(bend_count);
+}
+
+/// @brief Thread counts in powers of two up to all hardware threads
+void thread_counts(benchmark::internal::Benchmark *benchmark) {
+  const auto max_thread_count =
+      std::max(1U, std::thread::hardware_concurrency());
+  for (unsigned thread_count = 1; thread_count < max_thread_count;
+       thread_count *= 2) {
+    benchmark->Arg(thread_count);
+  }
+  benchmark->Arg(max_thread_count);
+}
+BENCHMARK(way_batch_pool)
+    ->Apply(thread_counts)
+    ->ArgName("threads")
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
@@ -0,0 +1,72 @@
+#include <benchmark/benchmark.h>
+
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/way.hpp>
+#include <vector>
+
+#include "synthetic_roads.hpp"
+#include "way_filter.hpp"
+
+namespace {
+
+constexpr std::uint64_t SEED = 1;
+
+/// @brief Ways matched in turn
+constexpr std::size_t WAY_COUNT = 4096;
+
+constexpr std::size_t BUFFER_SIZE = 1U << 20U;
+
+/// @brief Filter of the default configuration with a regular expression and
+/// a lone key added
+auto get_filter_rules() -> ntask::FilterRules {
+  using Match = ntask::TagRule::Match;
+  return ntask::FilterRules{
+      .highway_tags = {"trunk", "primary", "secondary", "tertiary",
+                       "unclassified", "residential"},
+      .blacklisted_tags = {
+          {.key = "oneway", .value = "yes", .match = Match::value},
+          {.key = "junction", .value = "roundabout", .match = Match::value},
+          {.key = "area", .value = "", .match = Match::any_value},
+          {.key = "service",
+           .value = "parking_aisle|driveway",
+           .match = Match::value_regex}}};
+}
+
+/// @brief Tags of a way checked against the filters of all profiles, by the
+/// number of profiles
+void way_filter_match(benchmark::State &state) {
+  ntask::bench::SyntheticRoads roads{
+      ntask::bench::RoadShape{.node_count = 2,
+                              .node_spacing = 15,
+                              .turn_deviation = 10,
+                              .hairpin_share = 0},
+      SEED};
+  osmium::memory::Buffer buffer{BUFFER_SIZE,
+                                osmium::memory::Buffer::auto_grow::yes};
+  for (std::size_t way = 0; way < WAY_COUNT; ++way) {
+    ntask::bench::add_way(buffer, static_cast<osmium::object_id_type>(way),
+                          roads.next_way(), roads.next_tags());
+  }
+  std::vector<const osmium::Way *> ways;
+  for (const auto &way : buffer.select<osmium::Way>()) {
+    ways.push_back(&way);
+  }
+
+  const std::vector<ntask::FilterRules> profiles(
+      static_cast<std::size_t>(state.range(0)), get_filter_rules());
+  const ntask::WayFilter way_filter{profiles};
+  std::size_t way = 0;
+  std::size_t accepted = 0;
+  for (auto _ : state) {
+    const auto matched_profiles = way_filter.match(*ways[way]);
+    benchmark::DoNotOptimize(matched_profiles);
+    accepted += matched_profiles != 0 ? 1 : 0;
+    way = (way + 1) % ways.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["accepted_share"] =
+      static_cast<double>(accepted) / static_cast<double>(state.iterations());
+}
+BENCHMARK(way_filter_match)->Arg(1)->Arg(8)->Arg(64)->ArgName("profiles");
+
+}  // namespace
@@ -0,0 +1,50 @@
+#ifndef NTASK_ANGLE_KERNEL_HPP
+#define NTASK_ANGLE_KERNEL_HPP
+
+#include <span>
+#include <string_view>
+
+namespace ntask {
+
+/// @brief Batched evaluation of the angles at a node between one node before
+/// and many nodes after it, with a scalar implementation and vectorized ones
+/// picked by the features of the running CPU.
+///
+/// All implementations return bit-identical results. Both functions return
+/// the largest cosine (i.e. the smallest angle) of all pairs; pairs whose
+/// cosine is not within [-1, 1] due to rounding or a zero side have no angle
+/// and are skipped, the result is -infinity if no pair has an angle.
+struct AngleKernel {
+  /// @brief Cosines by the side lengths of each triangle
+  /// (https://en.wikipedia.org/wiki/Law_of_cosines)
+  /// @param dist_b Distance between the node before and the node
+  /// @param dist_a Distances between the node and each node after it
+  /// @param dist_c Distances between the node before and each node after
+  using SidesFunction = double (*)(double dist_b,
+                                   std::span<const double> dist_a,
+                                   std::span<const double> dist_c);
+
+  /// @brief Cosines by the dot product of the vectors from the node
+  /// @param x, y, norm Vector to the node before and its length
+  /// @param xs, ys, norms Vectors to each node after and their lengths
+  using VectorsFunction = double (*)(double x, double y, double norm,
+                                     std::span<const double> xs,
+                                     std::span<const double> ys,
+                                     std::span<const double> norms);
+
+  /// @brief `scalar`, `avx2` or `avx512`
+  std::string_view name;
+  SidesFunction max_cosine_by_sides;
+  VectorsFunction max_cosine_by_vectors;
+
+  /// @return Fastest kernel supported by this CPU
+  static auto get() -> const AngleKernel &;
+
+  /// @return Kernel by @c name or nullptr if this CPU or build does not
+  /// support it
+  static auto find(std::string_view name) -> const AngleKernel *;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,263 @@
+#ifndef NTASK_BEND_DETECTOR_HPP
+#define NTASK_BEND_DETECTOR_HPP
+
+#include <cstdint>
+#include <optional>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <span>
+#include <vector>
+
+#include "angle_kernel.hpp"
+#include "profile_mask.hpp"
+#include "way_simplifier.hpp"
+
+namespace ntask {
+
+/// @brief Finds the nodes of a single way forming a tight angle with their
+/// neighbours.
+///
+/// The angle at a node is the smallest angle of all triangles formed with a
+/// node before and a node after it, both within the distance threshold and
+/// not separated from it by a node outside of the threshold. Nodes without a
+/// valid location are never part of a window. Distances between two nodes of
+/// the way are memoized, a node pair shows up in the windows of every node
+/// between them.
+///
+/// Several profiles with their own thresholds can be evaluated in one scan:
+/// the window is measured once for the largest distance threshold and the
+/// window of each profile is a part of it, sharing the memoized distances.
+///
+/// Densely traced ways can be simplified before the scan: with fewer nodes
+/// each window holds far fewer pairs. Found nodes keep their IDs.
+///
+/// Most ways have no bend at all, which their curvature proves in one pass
+/// over the nodes: the angle at a node is at least 180° minus the turning of
+/// the way around it. Ways that turn too little within any stretch a window
+/// can span are skipped without a search, with the same result.
+/// @note Keeps scratch memory between calls, use one detector per thread
+class BendDetector {
+ public:
+  /// @brief How distances between nodes are measured
+  enum class DistanceModel {
+    /// @brief Great circle distance with the haversine formula
+    haversine,
+
+    /// @brief Euclidean distance after projecting the way once to an
+    /// equirectangular plane, scaled by the mean latitude of each node pair.
+    /// Against haversine the relative error stays below 1e-10 for nodes up to
+    /// 100 m and below 1e-7 for nodes up to 1 km apart, up to 80° latitude; it
+    /// grows with the square of the distance.
+    planar
+  };
+
+  /// @brief Thresholds of one profile
+  struct Thresholds {
+    /// @brief Distance in meter to search for finding two nodes around a
+    /// specific node in a road to construct a tight angle
+    double distance_threshold;
+
+    /// @brief Angles less than this threshold will be marked as dangerous
+    /// bend
+    /// @note Unit is degree
+    double angle_threshold;
+  };
+
+  /// @brief Node found by a profile
+  struct Bend {
+    osmium::NodeRef node;
+    std::size_t profile;
+
+    /// @brief Smallest angle at the node within the window of the profile
+    /// @note Unit is degree
+    double min_angle;
+
+    /// @brief Way the node was found in, 0 unless set by the caller of
+    /// @c detect
+    osmium::object_id_type way_id;
+  };
+
+  /// @brief Work done by a detector, summed over the scanned ways
+  struct Counters {
+    /// @brief Ways scanned for at least one profile
+    std::uint64_t way_count = 0;
+
+    /// @brief Scanned ways with at least one found node
+    std::uint64_t flagged_way_count = 0;
+
+    /// @brief Distances measured between two nodes
+    std::uint64_t distance_count = 0;
+
+    /// @brief Angles evaluated between a node before and a node after
+    std::uint64_t angle_count = 0;
+
+    /// @brief Nodes left out by the simplification before scanning
+    std::uint64_t simplified_node_count = 0;
+
+    /// @brief Ways proven free of bends by their curvature, without a window
+    /// search
+    std::uint64_t skipped_way_count = 0;
+
+    auto operator+=(const Counters &other) -> Counters &;
+  };
+
+  /// @param distance_threshold Distance in meter to search for finding two
+  /// nodes around a specific node in a road to construct a tight angle
+  /// @param angle_threshold Angles less than this threshold will be marked as
+  /// dangerous bend
+  /// @param distance_model How to measure distances between nodes
+  /// @note Unit of @p angle_threshold is degree
+  BendDetector(double distance_threshold, double angle_threshold,
+               DistanceModel distance_model = DistanceModel::haversine);
+
+  /// @param profiles Thresholds of each profile, at most @c MAX_PROFILES
+  /// @param distance_model How to measure distances between nodes
+  /// @param simplify_tolerance Simplify ways before scanning them, leaving
+  /// out nodes up to this distance in meter from the simplified way (see
+  /// @c WaySimplifier); 0 to scan every node
+  BendDetector(const std::vector<Thresholds> &profiles,
+               DistanceModel distance_model, double simplify_tolerance = 0);
+
+  /// @brief Scan the nodes of a way with the thresholds of the first profile
+  /// @param nodes Nodes of the way with their locations
+  /// @param dangerous_bends Found nodes are appended here in way order
+  void detect(std::span<const osmium::NodeRef> nodes,
+              std::vector<osmium::NodeRef> &dangerous_bends);
+
+  /// @brief Scan the nodes of a way for some of the profiles
+  /// @param nodes Nodes of the way with their locations
+  /// @param profiles Profiles to scan the way for
+  /// @param dangerous_bends Found nodes are appended here in way order, the
+  /// profiles of a node in ascending order
+  void detect(std::span<const osmium::NodeRef> nodes, ProfileMask profiles,
+              std::vector<Bend> &dangerous_bends);
+
+  /// @brief Scan a way given by the locations of its nodes, e.g. from a road
+  /// graph held in memory
+  /// @param locations Locations of the nodes of the way
+  /// @param profiles Profiles to scan the way for
+  /// @param dangerous_bends Found nodes are appended here in way order, with
+  /// their index into @p locations as node ID
+  void detect(std::span<const osmium::Location> locations,
+              ProfileMask profiles, std::vector<Bend> &dangerous_bends);
+
+  /// @return Work done by this detector so far
+  [[nodiscard]] auto get_counters() const noexcept -> const Counters &;
+
+  /// @brief Skip ways proven free of bends by their curvature (default) or
+  /// search every way, e.g. to compare both
+  void set_curvature_check(bool enabled) noexcept;
+
+ private:
+  /// @brief Node of the current way projected by the planar distance model
+  struct ProjectedNode {
+    /// @brief Longitude in radian times earth radius
+    double x;
+
+    /// @brief Latitude in radian times earth radius
+    double y;
+
+    /// @brief Cosine of the latitude, scale of @c x at this node
+    double scale;
+  };
+
+  /// @return Distance between the nodes @p from and @p to of the current way
+  /// with the configured distance model
+  [[nodiscard]] auto measure(std::size_t from, std::size_t to) const -> double;
+
+  /// @return Distances from node @p from to the nodes after it up to node
+  /// @p to (inclusive) of the current way
+  auto get_distances(std::size_t from, std::size_t to)
+      -> std::span<const double>;
+
+  /// @return Distance between the nodes @p from < @p to of the current way
+  auto get_distance(std::size_t from, std::size_t to) -> double;
+
+  /// @brief Project the nodes of the current way for the planar model and
+  /// clear the memoized distances
+  void reset(std::span<const osmium::NodeRef> nodes);
+
+  /// @return Cosine of the smallest angle at @p node_index with the first
+  /// @p right_count nodes of the right window, by the law of cosines on the
+  /// memoized distances of the triangle sides
+  auto get_max_cosine_by_sides(std::size_t node_index, std::size_t left_begin,
+                               std::size_t right_count) -> double;
+
+  /// @brief Load the vectors from the node at @p node_index to the nodes of
+  /// its window for @c get_max_cosine_by_vectors
+  void load_vectors(std::size_t node_index, std::size_t left_begin,
+                    std::size_t right_end);
+
+  /// @return Cosine of the smallest angle at the node of the loaded vectors
+  /// with the left vectors from @p left_offset and the first @p right_count
+  /// right vectors, with dot products of the projected vectors
+  auto get_max_cosine_by_vectors(std::size_t left_offset,
+                                 std::size_t right_count) -> double;
+
+  /// @return Cosine of the angle threshold in degree, clamped so that the
+  /// comparison of cosines still matches the comparison of angles
+  /// @note Cosines are compared instead of angles to avoid acos()
+  static auto get_cos_threshold(double angle_threshold) -> double;
+
+  /// @return Turning in radian a way may stay below within @c turn_span so
+  /// that no angle is below the angle threshold in degree, 0 if no way can
+  /// be proven free of bends
+  static auto get_max_turn(double angle_threshold) -> double;
+
+  /// @return Whether the way of @p nodes turns less than @p max_turn within
+  /// any stretch of @p turn_span meter, which proves that no node is a bend
+  /// (see @c get_max_turn)
+  auto is_free_of_bends(std::span<const osmium::NodeRef> nodes,
+                        double max_turn, double turn_span) -> bool;
+
+  /// @brief Vectors from the current node to its window nodes
+  struct Vectors {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> norm;
+  };
+
+  /// @brief Thresholds of a profile as compared while scanning
+  struct Profile {
+    double distance_threshold;
+    double cos_threshold;
+
+    /// @brief Ways turning less than this in radian within @c turn_span
+    /// meter have no bend, see @c is_free_of_bends
+    double max_turn;
+    double turn_span;
+  };
+
+  std::vector<Profile> profiles;
+  DistanceModel distance_model;
+  AngleKernel angle_kernel;
+  std::optional<WaySimplifier> simplifier;
+  bool curvature_check = true;
+
+  std::span<const osmium::NodeRef> nodes;
+  std::vector<ProjectedNode> projected_nodes;
+
+  /// @brief `distances[i][j]` is the distance between node `i` and `i + j + 1`
+  /// of the current way, rows are filled on demand
+  std::vector<std::vector<double>> distances;
+
+  std::vector<double> right_distances;
+  std::vector<std::size_t> active_profiles;
+  std::vector<Bend> profile_bends;
+  std::vector<osmium::NodeRef> location_nodes;
+
+  /// @brief Turning at a node of a way and the length of the way up to it,
+  /// see @c is_free_of_bends
+  struct Turn {
+    double position;
+    double angle;
+  };
+  std::vector<Turn> turns;
+  Vectors left_vectors;
+  Vectors right_vectors;
+  Counters counters;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,400 @@
+#ifndef NTASK_BEND_INDEX_HPP
+#define NTASK_BEND_INDEX_HPP
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <numbers>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "bend_table.hpp"
+
+namespace ntask {
+
+/// @brief Header at the start of a bend index file
+struct BendIndexHeader {
+  static constexpr std::array<char, 8> MAGIC{'N', 'T', 'B', 'I',
+                                             'D', 'X', '\0', '\0'};
+
+  /// @brief Version of the layout of the file, changed with every
+  /// incompatible change
+  static constexpr std::uint32_t VERSION = 1;
+
+  std::array<char, 8> magic;
+  std::uint32_t version;
+
+  /// @brief Size of a record in bytes
+  std::uint32_t record_size;
+
+  std::uint64_t record_count;
+
+  /// @brief Number of boxes of all levels of the tree
+  std::uint64_t box_count;
+
+  /// @brief Number of children of a tree node
+  std::uint32_t node_size;
+
+  /// @brief Whether every node is in the index once, with the number of ways
+  /// it was found in
+  std::uint32_t deduplicated;
+};
+
+/// @brief Bounding box in the fixed-point coordinates of @c BendRecord,
+/// both corners included
+struct BendBox {
+  std::int32_t min_lon;
+  std::int32_t min_lat;
+  std::int32_t max_lon;
+  std::int32_t max_lat;
+
+  /// @brief Smallest box containing the given box in degree
+  static auto from_degrees(double min_lon, double min_lat, double max_lon,
+                           double max_lat) -> BendBox {
+    constexpr double PRECISION = BendTableHeader::COORDINATE_PRECISION;
+    return BendBox{
+        .min_lon = static_cast<std::int32_t>(std::floor(min_lon * PRECISION)),
+        .min_lat = static_cast<std::int32_t>(std::floor(min_lat * PRECISION)),
+        .max_lon = static_cast<std::int32_t>(std::ceil(max_lon * PRECISION)),
+        .max_lat = static_cast<std::int32_t>(std::ceil(max_lat * PRECISION))};
+  }
+
+  [[nodiscard]] auto intersects(const BendBox &other) const noexcept -> bool {
+    return min_lon <= other.max_lon && other.min_lon <= max_lon &&
+           min_lat <= other.max_lat && other.min_lat <= max_lat;
+  }
+
+  [[nodiscard]] auto contains(const BendRecord &record) const noexcept
+      -> bool {
+    return min_lon <= record.lon && record.lon <= max_lon &&
+           min_lat <= record.lat && record.lat <= max_lat;
+  }
+};
+
+/// @brief Point of a route in degree
+struct RoutePoint {
+  double lon;
+  double lat;
+};
+
+/// @brief Bend found along a route
+struct CorridorBend {
+  /// @brief Record in the index
+  const BendRecord *record;
+
+  /// @brief Distance to the route in meter
+  double distance;
+
+  /// @brief Distance from the start of the route to the point of the route
+  /// closest to the bend in meter
+  double position;
+};
+
+static_assert(sizeof(BendIndexHeader) == 40 && sizeof(BendBox) == 16,
+              "Layout of bend index version 1");
+
+/// @brief Read-only bend index file mapped into memory: the bends sorted
+/// along a Hilbert curve and a packed R-tree over them, both used in place.
+///
+/// The file holds the header, the records, and the boxes of the tree level by
+/// level from the leaves up to the root. The box @c i of the lowest level
+/// bounds the records from @c i * node_size on, the box @c i of a higher
+/// level the boxes from @c i * node_size on of the level below. The levels
+/// follow from the number of records, only the boxes are stored.
+///
+/// Self-contained (POSIX only), consumers can copy this header alone with
+/// bend_table.hpp.
+class BendIndex {
+ public:
+  /// @brief Mean earth radius in meter, the same as osmium uses
+  static constexpr double EARTH_RADIUS_IN_METERS = 6372797.560856;
+
+  /// @throws std::runtime_error if the file can not be mapped or is not a
+  /// bend index of this version
+  explicit BendIndex(const std::string &path) : file(path) {
+    if (file.get_size() < sizeof(BendIndexHeader)) {
+      throw std::runtime_error("Not a bend index: " + path);
+    }
+    const auto &header = get_header();
+    if (header.magic != BendIndexHeader::MAGIC ||
+        header.version != BendIndexHeader::VERSION ||
+        header.record_size != sizeof(BendRecord) || header.node_size < 2) {
+      throw_invalid(path);
+    }
+
+    std::uint64_t box_count = 0;
+    for (auto size = header.record_count; size > 0;) {
+      size = (size + header.node_size - 1) / header.node_size;
+      level_begins.push_back(static_cast<std::size_t>(box_count));
+      box_count += size;
+      if (size == 1) {
+        break;
+      }
+    }
+    level_begins.push_back(static_cast<std::size_t>(box_count));
+    if (header.box_count != box_count ||
+        file.get_size() != sizeof(BendIndexHeader) +
+                               (header.record_count * sizeof(BendRecord)) +
+                               (box_count * sizeof(BendBox))) {
+      throw_invalid(path);
+    }
+  }
+
+  [[nodiscard]] auto get_header() const noexcept -> const BendIndexHeader & {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return *reinterpret_cast<const BendIndexHeader *>(file.get_data());
+  }
+
+  /// @return All bends in the order of the Hilbert curve
+  [[nodiscard]] auto records() const noexcept -> std::span<const BendRecord> {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<const BendRecord *>(file.get_data() +
+                                                 sizeof(BendIndexHeader)),
+            static_cast<std::size_t>(get_header().record_count)};
+  }
+
+  /// @brief Call @p visitor with every bend in @p box
+  /// @param box Box not crossing the antimeridian, `min_lon <= max_lon`
+  template <typename TVisitor>
+  void query(const BendBox &box, TVisitor &&visitor) const {
+    if (level_begins.size() < 2) {
+      return;
+    }
+    const auto all_records = records();
+    const auto all_boxes = boxes();
+    const auto node_size = get_header().node_size;
+
+    struct Node {
+      std::size_t level;
+      std::size_t index;
+    };
+    std::vector<Node> stack;
+    stack.reserve(level_begins.size() * node_size);
+    stack.push_back(Node{.level = level_begins.size() - 2, .index = 0});
+    while (!stack.empty()) {
+      const auto [level, index] = stack.back();
+      stack.pop_back();
+      if (!all_boxes[level_begins[level] + index].intersects(box)) {
+        continue;
+      }
+
+      const auto begin = index * node_size;
+      if (level == 0) {
+        const auto end =
+            std::min<std::size_t>(begin + node_size, all_records.size());
+        for (auto record = begin; record < end; ++record) {
+          if (box.contains(all_records[record])) {
+            visitor(all_records[record]);
+          }
+        }
+      } else {
+        const auto level_size = level_begins[level] - level_begins[level - 1];
+        const auto end = std::min<std::size_t>(begin + node_size, level_size);
+        for (auto child = begin; child < end; ++child) {
+          stack.push_back(Node{.level = level - 1, .index = child});
+        }
+      }
+    }
+  }
+
+  /// @brief Call @p visitor with every bend within @p radius meter of a
+  /// point, by great-circle distance
+  template <typename TVisitor>
+  void query_radius(double lon, double lat, double radius,
+                    TVisitor &&visitor) const {
+    // Bounding box of the spherical cap around the point, its longitudes
+    // reach to the meridians touching the cap
+    const auto angular_radius = radius / EARTH_RADIUS_IN_METERS;
+    const auto min_lat = lat - (angular_radius / DEGREE);
+    const auto max_lat = lat + (angular_radius / DEGREE);
+    const auto in_radius = [&](const BendRecord &record) {
+      if (get_distance(lon, lat, record.get_lon(), record.get_lat()) <=
+          radius) {
+        visitor(record);
+      }
+    };
+    if (min_lat <= -MAX_LAT || max_lat >= MAX_LAT ||
+        std::sin(angular_radius) >= std::cos(lat * DEGREE)) {
+      // The cap contains a pole and all longitudes
+      query_wrapped(-MAX_LON, min_lat, MAX_LON, max_lat, in_radius);
+      return;
+    }
+    const auto lon_radius =
+        std::asin(std::sin(angular_radius) / std::cos(lat * DEGREE)) / DEGREE;
+    query_wrapped(lon - lon_radius, min_lat, lon + lon_radius, max_lat,
+                  in_radius);
+  }
+
+  /// @brief Bends within @p width meter of the polyline @p route.
+  ///
+  /// Every segment is looked up in the tree on its own, with its bounding
+  /// box widened by @p width; distances within a segment are measured in a
+  /// plane tangent at the segment, close to great-circle distances for
+  /// segments of up to some ten kilometers.
+  /// @return Each bend once with its distance to the closest segment, in the
+  /// order of their positions along the route
+  [[nodiscard]] auto query_corridor(std::span<const RoutePoint> route,
+                                    double width) const
+      -> std::vector<CorridorBend> {
+    constexpr double METERS_PER_DEGREE = EARTH_RADIUS_IN_METERS * DEGREE;
+    std::vector<CorridorBend> bends;
+    if (route.empty()) {
+      return bends;
+    }
+    double segment_position = 0;
+    // A route of one point has one segment of length 0
+    const auto segment_count = std::max<std::size_t>(route.size(), 2) - 1;
+    for (std::size_t segment = 0; segment < segment_count; ++segment) {
+      const auto &from = route[segment];
+      const auto &to = route[std::min(segment + 1, route.size() - 1)];
+
+      const auto lon_delta = get_lon_delta(from.lon, to.lon);
+      const auto lon_scale =
+          std::cos((from.lat + to.lat) / 2 * DEGREE) * METERS_PER_DEGREE;
+      const auto segment_x = lon_delta * lon_scale;
+      const auto segment_y = (to.lat - from.lat) * METERS_PER_DEGREE;
+      const auto length_squared =
+          (segment_x * segment_x) + (segment_y * segment_y);
+      const auto in_width = [&](const BendRecord &record) {
+        const auto x = get_lon_delta(from.lon, record.get_lon()) * lon_scale;
+        const auto y = (record.get_lat() - from.lat) * METERS_PER_DEGREE;
+        const auto share =
+            length_squared > 0
+                ? std::clamp(((x * segment_x) + (y * segment_y)) /
+                                 length_squared,
+                             0.0, 1.0)
+                : 0.0;
+        const auto distance =
+            std::hypot(x - (share * segment_x), y - (share * segment_y));
+        if (distance <= width) {
+          bends.push_back(CorridorBend{
+              .record = &record,
+              .distance = distance,
+              .position =
+                  segment_position + (share * std::sqrt(length_squared))});
+        }
+      };
+
+      // The box is widened by the longitudes of the width at the latitude
+      // closest to a pole, wider than the plane of the segment needs
+      const auto lat_width = width / METERS_PER_DEGREE;
+      const auto min_lat = std::min(from.lat, to.lat) - lat_width;
+      const auto max_lat = std::max(from.lat, to.lat) + lat_width;
+      const auto pole_cosine =
+          std::cos(std::min(std::max(-min_lat, max_lat), MAX_LAT) * DEGREE);
+      if (pole_cosine * MAX_LON <= lat_width) {
+        query_wrapped(-MAX_LON, min_lat, MAX_LON, max_lat, in_width);
+      } else {
+        const auto lon_width = lat_width / pole_cosine;
+        query_wrapped(from.lon + std::min(lon_delta, 0.0) - lon_width, min_lat,
+                      from.lon + std::max(lon_delta, 0.0) + lon_width, max_lat,
+                      in_width);
+      }
+      segment_position += std::sqrt(length_squared);
+    }
+
+    // Bends near a vertex are found by both of its segments, keep the closer
+    std::sort(bends.begin(), bends.end(),
+              [](const CorridorBend &left, const CorridorBend &right) {
+                return left.record != right.record
+                           ? left.record < right.record
+                           : left.distance < right.distance;
+              });
+    bends.erase(std::unique(bends.begin(), bends.end(),
+                            [](const CorridorBend &left,
+                               const CorridorBend &right) {
+                              return left.record == right.record;
+                            }),
+                bends.end());
+    std::sort(bends.begin(), bends.end(),
+              [](const CorridorBend &left, const CorridorBend &right) {
+                return left.position < right.position;
+              });
+    return bends;
+  }
+
+  /// @return Great-circle distance between two points in meter
+  static auto get_distance(double lon1, double lat1, double lon2, double lat2)
+      -> double {
+    const auto lat_sine = std::sin((lat2 - lat1) * DEGREE / 2);
+    const auto lon_sine = std::sin((lon2 - lon1) * DEGREE / 2);
+    const auto haversine =
+        (lat_sine * lat_sine) + (std::cos(lat1 * DEGREE) *
+                                 std::cos(lat2 * DEGREE) * lon_sine * lon_sine);
+    return 2 * EARTH_RADIUS_IN_METERS *
+           std::asin(std::sqrt(std::min(haversine, 1.0)));
+  }
+
+ private:
+  static constexpr double DEGREE = std::numbers::pi / 180;
+  static constexpr double MAX_LAT = 90;
+  static constexpr double MAX_LON = 180;
+  static constexpr double FULL_TURN = 360;
+
+  /// @return Longitude of @p to east of @p from, in [-180, 180)
+  static auto get_lon_delta(double from, double to) -> double {
+    auto delta = to - from;
+    if (delta >= MAX_LON) {
+      delta -= FULL_TURN;
+    } else if (delta < -MAX_LON) {
+      delta += FULL_TURN;
+    }
+    return delta;
+  }
+
+  /// @brief @c query() a box whose longitudes may reach up to one turn
+  /// beyond the antimeridian, as up to two boxes within it
+  template <typename TVisitor>
+  void query_wrapped(double min_lon, double min_lat, double max_lon,
+                     double max_lat, TVisitor &&visitor) const {
+    min_lat = std::max(min_lat, -MAX_LAT);
+    max_lat = std::min(max_lat, MAX_LAT);
+    if (max_lon - min_lon >= FULL_TURN) {
+      query(BendBox::from_degrees(-MAX_LON, min_lat, MAX_LON, max_lat),
+            visitor);
+      return;
+    }
+    query(BendBox::from_degrees(std::max(min_lon, -MAX_LON), min_lat,
+                                std::min(max_lon, MAX_LON), max_lat),
+          visitor);
+    // The part beyond the antimeridian
+    if (min_lon < -MAX_LON) {
+      query(BendBox::from_degrees(min_lon + FULL_TURN, min_lat, MAX_LON,
+                                  max_lat),
+            visitor);
+    } else if (max_lon > MAX_LON) {
+      query(BendBox::from_degrees(-MAX_LON, min_lat, max_lon - FULL_TURN,
+                                  max_lat),
+            visitor);
+    }
+  }
+
+  [[noreturn]] static void throw_invalid(const std::string &path) {
+    throw std::runtime_error("Not a bend index of version " +
+                             std::to_string(BendIndexHeader::VERSION) + ": " +
+                             path);
+  }
+
+  [[nodiscard]] auto boxes() const noexcept -> std::span<const BendBox> {
+    const auto &header = get_header();
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<const BendBox *>(
+                file.get_data() + sizeof(BendIndexHeader) +
+                (header.record_count * sizeof(BendRecord))),
+            static_cast<std::size_t>(header.box_count)};
+  }
+
+  MappedFile file;
+
+  /// @brief Index of the first box of every level from the leaves up, and
+  /// the number of boxes at the end
+  std::vector<std::size_t> level_begins;
+};
+
+}  // namespace ntask
+
+#endif
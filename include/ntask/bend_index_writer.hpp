@@ -0,0 +1,41 @@
+#ifndef NTASK_BEND_INDEX_WRITER_HPP
+#define NTASK_BEND_INDEX_WRITER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "bend_index.hpp"
+
+namespace ntask {
+
+/// @brief Builds a bend index (see @c BendIndex) over dangerous bends.
+///
+/// The tree needs all bends, they are kept as 32 byte records until
+/// @c close() sorts them along a Hilbert curve and writes the file.
+class BendIndexWriter {
+ public:
+  /// @brief Number of children of a tree node
+  static constexpr std::uint32_t NODE_SIZE = 16;
+
+  /// @param path Output file, truncated on @c close()
+  /// @param deduplicated Whether every node is written once
+  BendIndexWriter(std::string path, bool deduplicated);
+
+  /// @brief Add the record of a node
+  /// @param way_count Number of ways the node was found in
+  void write(const BendDetector::Bend &bend, std::uint32_t way_count = 1);
+
+  /// @brief Sort the records, pack the tree and write the file
+  void close();
+
+ private:
+  std::string path;
+  bool deduplicated;
+  std::vector<BendRecord> records;
+};
+
+}  // namespace ntask
+
+#endif
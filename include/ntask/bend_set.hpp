@@ -0,0 +1,67 @@
+#ifndef NTASK_BEND_SET_HPP
+#define NTASK_BEND_SET_HPP
+
+#include <cstdint>
+#include <osmium/osm/node_ref.hpp>
+#include <span>
+#include <vector>
+
+#include "bend_detector.hpp"
+
+namespace ntask {
+
+/// @brief Deduplicates dangerous bends by node ID and counts the distinct
+/// ways each node was found in (e.g. the ways meeting at it).
+///
+/// Open addressing hash set with linear probing over 32 bit indices into an
+/// insertion ordered entry vector: 32 bytes per distinct node for the entry
+/// and 8 to 16 bytes for slots.
+class BendSet {
+ public:
+  struct Entry {
+    osmium::NodeRef node;
+
+    /// @brief Way the node was first found in
+    osmium::object_id_type way_id;
+
+    /// @brief Smallest angle at the node of all ways in degree
+    float min_angle;
+
+    /// @brief Number of distinct ways the node was added by
+    std::uint32_t way_count;
+  };
+
+  /// @brief Add a found node, the nodes of a way one after another so that a
+  /// way passing a node twice counts once
+  /// @return Whether the node was not in the set before
+  auto add(const BendDetector::Bend &bend) -> bool;
+
+  /// @return Distinct nodes in the order they were first added
+  [[nodiscard]] auto get_entries() const noexcept -> std::span<const Entry>;
+
+  /// @return Number of nodes added including duplicates
+  [[nodiscard]] auto get_added_count() const noexcept -> std::size_t;
+
+  /// @return Bytes allocated by the set
+  [[nodiscard]] auto used_memory() const noexcept -> std::size_t;
+
+ private:
+  void grow();
+  [[nodiscard]] auto get_slot(osmium::object_id_type id) const noexcept
+      -> std::size_t;
+
+  std::vector<Entry> entries;
+
+  /// @brief Entry index + 1 per slot, 0 marks an empty slot
+  std::vector<std::uint32_t> slots;
+
+  std::size_t added_count = 0;
+
+  /// @brief Way of the last added node and the entries added by it
+  osmium::object_id_type current_way_id = 0;
+  std::vector<std::uint32_t> current_way_entries;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,201 @@
+#ifndef NTASK_BEND_STATE_HPP
+#define NTASK_BEND_STATE_HPP
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <osmium/handler.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "boundary.hpp"
+#include "way_cache.hpp"
+#include "way_filter.hpp"
+
+namespace ntask {
+
+/// @brief Result of a run kept for incremental updates: every accepted way
+/// with its node locations, the profiles accepting it and the bends found on
+/// it.
+///
+/// File layout (native byte order): a fixed size header, the way IDs, the
+/// profiles of each way, `way_count + 1` offsets into the node refs,
+/// `way_count + 1` offsets into the bends, all node refs, all bends and the
+/// IDs of the stale ways.
+class BendState {
+ public:
+  /// @brief Identifies the filters and thresholds a state was computed with,
+  /// a state is only updated with the same configuration
+  struct Key {
+    std::uint64_t filter_hash;
+    std::uint64_t detector_hash;
+
+    /// @brief Compute the key of the filters and thresholds of all profiles
+    /// @param boundary_hash Hash of the boundary the input is read within, 0
+    /// without a boundary
+    /// @param simplify_tolerance Simplification tolerance of the detector, 0
+    /// without simplification
+    static auto make(const std::vector<FilterRules> &filter_rules,
+                     const std::vector<BendDetector::Thresholds> &thresholds,
+                     BendDetector::DistanceModel distance_model,
+                     std::uint64_t boundary_hash,
+                     double simplify_tolerance = 0) -> Key;
+
+    auto operator==(const Key &other) const -> bool = default;
+  };
+
+  /// @brief Accepted way of the state
+  struct WayState {
+    ProfileMask profiles = 0;
+    std::vector<osmium::NodeRef> nodes;
+    std::vector<BendDetector::Bend> bends;
+  };
+
+  explicit BendState(const Key &key);
+
+  /// @brief Read a state file
+  /// @return Nothing if the file does not exist or is not a state of this
+  /// version
+  /// @throws std::runtime_error If the state was computed for another @p key
+  static auto load(const std::string &path, const Key &key)
+      -> std::optional<BendState>;
+
+  /// @brief Write the state to a temporary file and move it to @p path
+  void save(const std::string &path) const;
+
+  /// @return Accepted ways by ID
+  [[nodiscard]] auto get_ways() const noexcept
+      -> const std::map<osmium::object_id_type, WayState> &;
+
+  /// @brief Add, replace or (without @p way_state) remove a way
+  void set_way(osmium::object_id_type way_id,
+               std::optional<WayState> way_state);
+
+  /// @return Ways whose latest version could not be scanned by an update,
+  /// the state holds their previous version if any until a full run
+  [[nodiscard]] auto get_stale_ways() const noexcept
+      -> const std::set<osmium::object_id_type> &;
+
+  /// @brief Mark a way as stale or, once its latest version is applied, as
+  /// up to date
+  void set_stale(osmium::object_id_type way_id, bool stale);
+
+ private:
+  struct Header {
+    std::array<char, 8> magic;
+    std::uint64_t version;
+    Key key;
+    std::uint64_t way_count;
+    std::uint64_t node_count;
+    std::uint64_t bend_count;
+    std::uint64_t stale_way_count;
+  };
+
+  static constexpr std::array<char, 8> MAGIC{'N', 'T', 'B', 'S',
+                                             'T', 'A', 'T', 'E'};
+  static constexpr std::uint64_t VERSION = 3;
+
+  Key key;
+  std::map<osmium::object_id_type, WayState> ways;
+  std::set<osmium::object_id_type> stale_ways;
+};
+
+/// @brief Handler building a @c BendState from a full input. Ways must
+/// already have their node locations set.
+class BendStateBuilder : public osmium::handler::Handler {
+ public:
+  BendStateBuilder(BendState &state, const WayFilter &way_filter,
+                   BendDetector &detector);
+
+  void way(const osmium::Way &way);
+
+ private:
+  BendState &state;
+  const WayFilter &way_filter;
+  BendDetector &detector;
+};
+
+/// @brief Found node whose result changed with an update
+struct BendChange {
+  osmium::NodeRef node;
+  std::size_t profile;
+
+  /// @brief Whether the node is found now and was not before, otherwise it
+  /// was found before and is not anymore
+  bool added;
+};
+
+/// @brief Handler reading an OSM change file and applying it to a
+/// @c BendState.
+///
+/// Only ways changed directly or through a moved node are scanned again.
+/// Node locations come from the change file or else from the state, which
+/// holds the nodes of all accepted ways; a changed way referencing a node
+/// found in neither (e.g. a way joining the filters whose nodes did not
+/// change) can not be scanned. It keeps its previous version in the state,
+/// if any, without any change of its bends, and is marked as stale.
+///
+/// Like a full run within a boundary, changed nodes outside of it lose their
+/// location and ways without any node inside are left out of the state.
+class BendStateUpdater : public osmium::handler::Handler {
+ public:
+  /// @param boundary Boundary the state was computed within, if any
+  BendStateUpdater(BendState &state, const WayFilter &way_filter,
+                   BendDetector &detector,
+                   const Boundary *boundary = nullptr);
+
+  void node(const osmium::Node &node);
+  void way(const osmium::Way &way);
+
+  /// @brief Apply the changes read so far to the state
+  /// @return Nodes found or not found anymore by each profile, ordered by
+  /// profile and node ID; a node still found at another location is removed
+  /// at its old location and added at its new one
+  auto apply() -> std::vector<BendChange>;
+
+  /// @return Number of ways scanned again by @c apply
+  [[nodiscard]] auto get_updated_way_count() const noexcept -> std::size_t;
+
+  /// @return Number of ways @c apply could not scan for missing node
+  /// locations and marked as stale
+  [[nodiscard]] auto get_unresolved_way_count() const noexcept
+      -> std::size_t;
+
+ private:
+  /// @brief New version of a way, without a value if it was deleted or is not
+  /// accepted by any profile anymore
+  struct ChangedWay {
+    ProfileMask profiles = 0;
+    std::vector<osmium::object_id_type> node_ids;
+  };
+
+  /// @brief Collect the locations of the nodes needed by changed ways and
+  /// the ways referencing moved nodes
+  void resolve(std::unordered_map<osmium::object_id_type, osmium::Location>
+                   &locations,
+               std::vector<osmium::object_id_type> &moved_ways) const;
+
+  BendState &state;
+  const WayFilter &way_filter;
+  BendDetector &detector;
+  const Boundary *boundary;
+
+  /// @brief New location of each changed node, invalid if it was deleted or
+  /// is outside of the boundary
+  std::unordered_map<osmium::object_id_type, osmium::Location> changed_nodes;
+  std::map<osmium::object_id_type, std::optional<ChangedWay>> changed_ways;
+
+  std::size_t updated_way_count = 0;
+  std::size_t unresolved_way_count = 0;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,190 @@
+#ifndef NTASK_BEND_TABLE_HPP
+#define NTASK_BEND_TABLE_HPP
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace ntask {
+
+// Records are stored in the byte order of the writer and read in place
+static_assert(std::endian::native == std::endian::little,
+              "Bend tables are little endian");
+
+/// @brief Header at the start of a bend table file
+struct BendTableHeader {
+  static constexpr std::array<char, 8> MAGIC{'N', 'T', 'B', 'E',
+                                             'N', 'D', 'S', '\0'};
+
+  /// @brief Version of the layout of header and records, changed with
+  /// every incompatible change
+  static constexpr std::uint32_t VERSION = 1;
+
+  /// @brief Fixed-point coordinates are degree times this
+  static constexpr std::int32_t COORDINATE_PRECISION = 10000000;
+
+  std::array<char, 8> magic;
+  std::uint32_t version;
+
+  /// @brief Size of a record in bytes, records may grow in later versions
+  std::uint32_t record_size;
+
+  std::uint64_t record_count;
+
+  /// @brief Whether every node is in the table once, with the number of ways
+  /// it was found in
+  std::uint32_t deduplicated;
+
+  std::uint32_t reserved;
+};
+
+/// @brief Dangerous bend of a bend table, fixed width
+struct BendRecord {
+  std::int64_t node_id;
+
+  /// @brief Way the node was (first) found in
+  std::int64_t way_id;
+
+  /// @brief Longitude in degree times
+  /// @c BendTableHeader::COORDINATE_PRECISION
+  std::int32_t lon;
+
+  /// @brief Latitude in degree times
+  /// @c BendTableHeader::COORDINATE_PRECISION
+  std::int32_t lat;
+
+  /// @brief Smallest angle at the node in degree
+  float min_angle;
+
+  /// @brief Number of ways the node was found in, 1 if not deduplicated
+  std::uint32_t way_count;
+
+  [[nodiscard]] auto get_lon() const noexcept -> double {
+    return static_cast<double>(lon) / BendTableHeader::COORDINATE_PRECISION;
+  }
+
+  [[nodiscard]] auto get_lat() const noexcept -> double {
+    return static_cast<double>(lat) / BendTableHeader::COORDINATE_PRECISION;
+  }
+};
+
+static_assert(sizeof(BendTableHeader) == 32 && sizeof(BendRecord) == 32,
+              "Layout of bend table version 1");
+
+/// @brief Read-only file mapped into memory
+class MappedFile {
+ public:
+  /// @throws std::runtime_error if the file can not be opened or mapped
+  explicit MappedFile(const std::string &path) {
+    const auto file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+      throw std::runtime_error("Can not open " + path);
+    }
+    struct stat status {};
+    if (::fstat(file, &status) != 0) {
+      ::close(file);
+      throw std::runtime_error("Can not open " + path);
+    }
+    size = static_cast<std::size_t>(status.st_size);
+    if (size == 0) {
+      // mmap() rejects empty mappings
+      ::close(file);
+      return;
+    }
+    data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, file, 0);
+    ::close(file);
+    if (data == MAP_FAILED) {
+      data = nullptr;
+      throw std::runtime_error("Can not map " + path);
+    }
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  auto operator=(const MappedFile &) -> MappedFile & = delete;
+
+  MappedFile(MappedFile &&other) noexcept
+      : data(std::exchange(other.data, nullptr)),
+        size(std::exchange(other.size, 0)) {}
+
+  auto operator=(MappedFile &&other) noexcept -> MappedFile & {
+    if (this != &other) {
+      unmap();
+      data = std::exchange(other.data, nullptr);
+      size = std::exchange(other.size, 0);
+    }
+    return *this;
+  }
+
+  ~MappedFile() { unmap(); }
+
+  [[nodiscard]] auto get_data() const noexcept -> const char * {
+    return static_cast<const char *>(data);
+  }
+
+  [[nodiscard]] auto get_size() const noexcept -> std::size_t { return size; }
+
+ private:
+  void unmap() noexcept {
+    if (data != nullptr) {
+      ::munmap(data, size);
+      data = nullptr;
+    }
+  }
+
+  void *data = nullptr;
+  std::size_t size = 0;
+};
+
+/// @brief Read-only bend table file mapped into memory, the records are used
+/// in place without parsing or copying.
+///
+/// Self-contained (POSIX only), consumers can copy this header alone.
+class BendTable {
+ public:
+  /// @throws std::runtime_error if the file can not be mapped or is not a
+  /// bend table of this version
+  explicit BendTable(const std::string &path) : file(path) {
+    if (file.get_size() < sizeof(BendTableHeader)) {
+      throw std::runtime_error("Not a bend table: " + path);
+    }
+    const auto &header = get_header();
+    if (header.magic != BendTableHeader::MAGIC ||
+        header.version != BendTableHeader::VERSION ||
+        header.record_size != sizeof(BendRecord) ||
+        header.record_count >
+            (file.get_size() - sizeof(BendTableHeader)) / sizeof(BendRecord)) {
+      throw std::runtime_error("Not a bend table of version " +
+                               std::to_string(BendTableHeader::VERSION) +
+                               ": " + path);
+    }
+  }
+
+  [[nodiscard]] auto get_header() const noexcept -> const BendTableHeader & {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return *reinterpret_cast<const BendTableHeader *>(file.get_data());
+  }
+
+  [[nodiscard]] auto records() const noexcept -> std::span<const BendRecord> {
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    return {reinterpret_cast<const BendRecord *>(file.get_data() +
+                                                 sizeof(BendTableHeader)),
+            static_cast<std::size_t>(get_header().record_count)};
+  }
+
+ private:
+  MappedFile file;
+};
+
+}  // namespace ntask
+
+#endif
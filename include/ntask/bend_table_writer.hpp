@@ -0,0 +1,37 @@
+#ifndef NTASK_BEND_TABLE_WRITER_HPP
+#define NTASK_BEND_TABLE_WRITER_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "bend_table.hpp"
+
+namespace ntask {
+
+/// @brief Writes dangerous bends to a bend table (see @c BendTable) one
+/// record at a time
+class BendTableWriter {
+ public:
+  /// @param path Output file, truncated
+  /// @param deduplicated Whether every node is written once
+  BendTableWriter(const std::string &path, bool deduplicated);
+
+  /// @brief Append the record of a node
+  /// @param way_count Number of ways the node was found in
+  void write(const BendDetector::Bend &bend, std::uint32_t way_count = 1);
+
+  /// @brief Write the number of records into the header and flush the output
+  void close();
+
+ private:
+  std::vector<char> buffer;
+  std::ofstream file;
+  BendTableHeader header;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef NTASK_BOUNDARY_HPP
+#define NTASK_BOUNDARY_HPP
+
+#include <cstdint>
+#include <osmium/handler.hpp>
+#include <osmium/osm/box.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <string>
+#include <vector>
+
+namespace ntask {
+
+/// @brief Area of interest, a bounding box or polygons with holes.
+///
+/// Points are tested with the even-odd rule, so rings of holes and of several
+/// polygons can be mixed freely. The bounding box of all rings is covered by
+/// a grid whose cells not crossed by any edge are known to be fully inside
+/// or outside; only points in cells crossed by edges are tested against the
+/// edges of a thin horizontal strip around them.
+class Boundary {
+ public:
+  /// @brief Closed ring of a polygon, the last vertex connects to the first
+  using Ring = std::vector<osmium::Location>;
+
+  /// @param rings Outer rings and holes of all polygons
+  explicit Boundary(const std::vector<Ring> &rings);
+
+  /// @return Boundary of the box from @p bottom_left to @p top_right, points
+  /// on its edges are inside
+  static auto from_box(const osmium::Location &bottom_left,
+                       const osmium::Location &top_right) -> Boundary;
+
+  /// @brief Read an Osmosis polygon filter file (`.poly`) or the polygons of
+  /// a GeoJSON file (`Polygon`/`MultiPolygon` geometries, features and
+  /// feature collections)
+  /// @throws std::runtime_error If the file can not be read or has no
+  /// polygon
+  static auto from_file(const std::string &path) -> Boundary;
+
+  /// @return Whether @p location is inside, invalid locations never are
+  [[nodiscard]] auto contains(const osmium::Location &location) const -> bool;
+
+  /// @return Hash of the rings
+  [[nodiscard]] auto get_hash() const noexcept -> std::uint64_t;
+
+ private:
+  /// @brief Edge in fixed point coordinates of @c osmium::Location
+  struct Edge {
+    double x1;
+    double y1;
+    double x2;
+    double y2;
+  };
+
+  enum class Cell : std::uint8_t { outside, inside, crossed };
+
+  /// @return Strip of the fixed point latitude @p y
+  [[nodiscard]] auto get_strip(double y) const -> std::size_t;
+
+  /// @return Whether a ray from the point to the right crosses an odd number
+  /// of edges, i.e. the point is inside
+  [[nodiscard]] auto crosses_odd(double x, double y) const -> bool;
+
+  osmium::Location bottom_left;
+  osmium::Location top_right;
+
+  /// @brief Whether the boundary is the box from @c bottom_left to
+  /// @c top_right, with its edges unlike the rings
+  bool is_box = false;
+
+  std::size_t grid_size = 1;
+  double cell_width = 1;
+  double cell_height = 1;
+  std::vector<Cell> cells;
+
+  std::size_t strip_count = 1;
+  double strip_height = 1;
+
+  /// @brief Edges overlapping each strip
+  std::vector<std::vector<Edge>> strip_edges;
+
+  std::uint64_t hash;
+};
+
+/// @brief Forwards to a location handler only the nodes inside a
+/// @c Boundary, nodes of ways outside the boundary are left without a
+/// location
+/// @note The wrapped handler has to ignore errors
+template <typename TLocationHandler>
+class BoundedNodeLocations : public osmium::handler::Handler {
+ public:
+  BoundedNodeLocations(const Boundary &boundary,
+                       TLocationHandler &location_handler)
+      : boundary(boundary), location_handler(location_handler) {}
+
+  void node(const osmium::Node &node) {
+    if (boundary.contains(node.location())) {
+      location_handler.node(node);
+    }
+  }
+
+  void way(osmium::Way &way) { location_handler.way(way); }
+
+ private:
+  const Boundary &boundary;
+  TLocationHandler &location_handler;
+};
+
+/// @brief Forwards to a handler only the ways with at least one node location,
+/// skips ways entirely outside of a @c Boundary
+template <typename THandler>
+class LocatedWays : public osmium::handler::Handler {
+ public:
+  explicit LocatedWays(THandler &handler) : handler(handler) {}
+
+  void way(const osmium::Way &way) {
+    for (const auto &node : way.nodes()) {
+      if (node.location().valid()) {
+        handler.way(way);
+        return;
+      }
+    }
+  }
+
+ private:
+  THandler &handler;
+};
+
+}  // namespace ntask
+
+#endif
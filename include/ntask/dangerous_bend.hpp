@@ -2,25 +2,33 @@
 #define NTASK_DANGEROUS_BEND_HPP
 
 #include <cmath>
+#include <functional>
+#include <memory>
 #include <osmium/handler.hpp>
 #include <osmium/osm/node_ref.hpp>
+#include <span>
 #include <string>
 #include <vector>
 
+#include "bend_detector.hpp"
+#include "way_batch_pool.hpp"
+#include "way_filter.hpp"
+#include "way_stitcher.hpp"
+
 namespace ntask {
 
 /// @brief Handler to scan the ways in a given map and find dangerous bends
 class DangerousBendHandler : public osmium::handler::Handler {
  public:
-  /// @brief Configuration of @c DangerousBendHandler
-  struct Configuration {
+  /// @brief Filters and thresholds of one set of results
+  struct Profile {
     /// @brief Ways without any of these values assigned to the key `highway`
     /// will be filtered out.
     std::vector<std::string> highway_tags;
 
-    /// @brief Ways with these tags will be filtered out (e.g. `oneway=yes` will
-    /// filter one-way roads).
-    std::vector<std::pair<std::string, std::string>> blacklisted_tags;
+    /// @brief Ways with tags matching these rules will be filtered out (e.g.
+    /// `oneway=yes` will filter one-way roads).
+    std::vector<TagRule> blacklisted_tags;
 
     /// @brief Distance threshold in meter to search for finding two nodes
     /// around a specific node in a road to construct a tight angle
@@ -31,33 +39,95 @@ class DangerousBendHandler : public osmium::handler::Handler {
     double angle_threshold;
   };
 
+  /// @brief Configuration of @c DangerousBendHandler
+  struct Configuration {
+    /// @brief Profiles evaluated together in one scan of each way, at most
+    /// @c MAX_PROFILES
+    std::vector<Profile> profiles;
+
+    /// @brief How distances between nodes are measured
+    BendDetector::DistanceModel distance_model =
+        BendDetector::DistanceModel::haversine;
+
+    /// @brief Number of threads scanning ways, with more than one thread the
+    /// ways are copied into batches and scanned in the background until
+    /// @c finish is called
+    std::size_t threads = 1;
+
+    /// @brief Ends of ways waiting at most for their continuing way to find
+    /// bends at the node they share (see @c WayStitcher), 0 to not stitch
+    /// ways. Only ways passed to @c way() are stitched, their tags tell
+    /// which ways continue each other.
+    std::size_t stitch_endpoints = 0;
+
+    /// @brief Simplify ways before scanning them, leaving out nodes up to
+    /// this distance in meter from the simplified way (see @c WaySimplifier),
+    /// 0 to scan every node. Stitched way ends are never simplified.
+    double simplify_tolerance = 0;
+
+    /// @return Filter rules of each profile
+    [[nodiscard]] auto get_filter_rules() const -> std::vector<FilterRules>;
+
+    /// @return Thresholds of each profile
+    [[nodiscard]] auto get_thresholds() const
+        -> std::vector<BendDetector::Thresholds>;
+  };
+
+  /// @brief Receives each found node in way order, nodes shared by the ends
+  /// of continuing ways after all others in @c finish
+  using BendSink = std::function<void(const BendDetector::Bend &)>;
+
   explicit DangerousBendHandler(const Configuration &configuration);
 
+  /// @param sink Receives the found nodes as soon as they are known instead
+  /// of collecting them for @c get_dangerous_bends
+  DangerousBendHandler(const Configuration &configuration, BendSink sink);
+
   void way(const osmium::Way &way);
 
+  /// @brief Scan the nodes of a way which already passed the filters
+  /// @param way_id ID of the way, set on its bends
+  /// @param nodes Nodes of the way with their locations, must stay valid
+  /// until @c finish returns
+  /// @param profiles Profiles whose filters the way passed
+  void add_dangerous_bend(osmium::object_id_type way_id,
+                          std::span<const osmium::NodeRef> nodes,
+                          ProfileMask profiles);
+
+  /// @brief Wait until all ways passed so far are scanned
+  void finish();
+
   /// @return Founded nodes related to a dangerous bend
+  /// @note The result is only complete after @c finish and stays empty if
+  /// the found nodes go to a sink
   [[nodiscard]] auto get_dangerous_bends() const noexcept
-      -> const std::vector<osmium::NodeRef> &;
+      -> const std::vector<BendDetector::Bend> &;
+
+  /// @return Work done scanning ways, complete after @c finish
+  [[nodiscard]] auto get_detector_counters() const -> BendDetector::Counters;
+
+  /// @return Stitcher of continuing ways, null if ways are not stitched
+  [[nodiscard]] auto get_stitcher() const noexcept -> const WayStitcher *;
 
  private:
-  void add_dangerous_bend(const osmium::Way &way);
-
-  /// @brief  Calculate the angle of a triangle
-  /// (https://en.wikipedia.org/wiki/Law_of_cosines).
-  /// @param node_a Fist node of triangle
-  /// @param node_c Second node of triangle, The return value is the angle
-  /// corresponding to this node
-  /// @param node_b Third node of triangle
-  /// @return The angle corresponding to @param node_c in Radian
-  static auto get_angle(const osmium::Location &node_a,
-                        const osmium::Location &node_c,
-                        const osmium::Location &node_b) -> double;
+  void submit_batch();
+  void emit(const std::vector<BendDetector::Bend> &bends);
 
   const Configuration configuration;
-  const double angle_threshold;
-  std::vector<osmium::NodeRef> dangerous_bends;
+  const WayFilter way_filter;
+  BendDetector detector;
+  std::unique_ptr<WayBatchPool> pool;
+  std::unique_ptr<WayStitcher> stitcher;
+  BendDetector::Counters pool_counters;
+  WayBatch batch;
+  std::size_t batch_node_count = 0;
+  BendSink sink;
+  std::vector<BendDetector::Bend> way_bends;
+  /// @brief Bends at the ends of stitched ways, emitted by @c finish
+  std::vector<BendDetector::Bend> junction_bends;
+  std::vector<BendDetector::Bend> dangerous_bends;
 };
 
 }  // namespace ntask
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,47 @@
+#ifndef NTASK_FNV_HASH_HPP
+#define NTASK_FNV_HASH_HPP
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+
+namespace ntask {
+
+constexpr std::uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ULL;
+
+/// @brief FNV-1a over 64 bit words (the tail is hashed byte by byte)
+inline auto fnv_hash_bytes(std::uint64_t hash, std::span<const char> bytes)
+    -> std::uint64_t {
+  std::size_t offset = 0;
+  for (; offset + sizeof(std::uint64_t) <= bytes.size();
+       offset += sizeof(std::uint64_t)) {
+    std::uint64_t word = 0;
+    std::memcpy(&word, &bytes[offset], sizeof word);
+    hash = (hash ^ word) * FNV_PRIME;
+  }
+  for (; offset < bytes.size(); ++offset) {
+    hash = (hash ^ static_cast<unsigned char>(bytes[offset])) * FNV_PRIME;
+  }
+  return hash;
+}
+
+inline auto fnv_hash_string(std::uint64_t hash, const std::string &value)
+    -> std::uint64_t {
+  // Include the terminating null so that ("ab", "c") != ("a", "bc")
+  return fnv_hash_bytes(hash, {value.c_str(), value.size() + 1});
+}
+
+/// @brief Hash the bytes of a trivially copyable value
+template <typename T>
+auto fnv_hash_value(std::uint64_t hash, const T &value) -> std::uint64_t {
+  std::array<char, sizeof(T)> bytes{};
+  std::memcpy(bytes.data(), &value, sizeof(T));
+  return fnv_hash_bytes(hash, bytes);
+}
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef NTASK_JSON_WRITER_HPP
+#define NTASK_JSON_WRITER_HPP
+
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <osmium/osm/node_ref.hpp>
+#include <string>
+#include <vector>
+
+namespace ntask {
+
+/// @brief Writes dangerous bends to a JSON array one record at a time,
+/// memory use does not depend on the number of records.
+///
+/// The output is the same as serializing the whole array with nlohmann::json.
+class JsonWriter {
+ public:
+  /// @param path Output file, truncated
+  /// @param compact Write without newlines and indentation
+  JsonWriter(const std::string &path, bool compact);
+
+  /// @brief Append the record of a node
+  /// @param way_count Number of ways the node was found in, only written if
+  /// set
+  void write(const osmium::NodeRef &node,
+             std::optional<std::uint32_t> way_count = std::nullopt);
+
+  /// @brief Terminate the array and flush the output
+  void close();
+
+ private:
+  std::vector<char> buffer;
+  std::ofstream file;
+  int indent;
+  std::string separator;
+  bool empty = true;
+};
+
+}  // namespace ntask
+
+#endif
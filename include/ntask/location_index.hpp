@@ -0,0 +1,49 @@
+#ifndef NTASK_LOCATION_INDEX_HPP
+#define NTASK_LOCATION_INDEX_HPP
+
+#include <cstdint>
+#include <memory>
+#include <osmium/index/map.hpp>
+#include <osmium/io/file.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/types.hpp>
+#include <string>
+
+namespace ntask {
+
+/// @brief Runtime selected node location index (see @c create_location_index)
+using LocationIndex =
+    osmium::index::map::Map<osmium::unsigned_object_id_type, osmium::Location>;
+
+/// @brief Create a node location index by its osmium map factory name
+/// @param name One of `sparse_mem_array`, `dense_mem_array`,
+/// `sparse_mmap_array`, `dense_mmap_array`, `flex_mem` or a file backed
+/// `sparse_file_array,<path>` / `dense_file_array,<path>`
+/// @throws std::runtime_error If @p name is not a known index type
+auto create_location_index(const std::string &name)
+    -> std::unique_ptr<LocationIndex>;
+
+/// @brief Suggest a location index for an input file.
+///
+/// @c flex_mem is suggested when the estimate is too close to call.
+/// The number of nodes is estimated from the file size and format. Dense
+/// arrays are indexed by node ID, so they only pay off when the file holds a
+/// good part of all nodes in OSM (i.e. the planet); sparse arrays store an
+/// (ID, location) pair per node. When the estimated index does not fit into
+/// @p memory_budget, the file backed variant of the same layout is suggested.
+/// @param file Input file, used for its format and compression
+/// @param file_size Size of the input file in bytes
+/// @param memory_budget Bytes of memory the index may use
+/// @param index_file File backing the index if it does not fit in memory
+/// @return A name accepted by @c create_location_index
+auto suggest_location_index(const osmium::io::File &file,
+                            std::uintmax_t file_size,
+                            std::uintmax_t memory_budget,
+                            const std::string &index_file) -> std::string;
+
+/// @return Physical memory of this machine in bytes
+auto get_physical_memory() -> std::uintmax_t;
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,156 @@
+#ifndef NTASK_PIPELINE_HPP
+#define NTASK_PIPELINE_HPP
+
+#include <chrono>
+#include <exception>
+#include <osmium/io/reader.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/visitor.hpp>
+#include <thread>
+
+#include "spsc_queue.hpp"
+
+namespace ntask {
+
+/// @brief Time spent by the stages of @c run_pipeline, the stage with the
+/// highest utilization limits the throughput
+struct PipelineStats {
+  /// @brief Time spent by one stage on its own thread
+  struct Stage {
+    /// @brief Time spent on its own work
+    std::chrono::nanoseconds busy{};
+
+    /// @brief Time spent waiting for the stage before or after it
+    std::chrono::nanoseconds waiting{};
+
+    /// @brief Number of buffers passed through
+    std::size_t buffers = 0;
+
+    /// @return Share of the time spent busy, between 0 and 1
+    [[nodiscard]] auto get_utilization() const noexcept -> double;
+  };
+
+  /// @brief Takes decoded buffers from the reader, whose own threads
+  /// decompress and parse the input
+  Stage read;
+
+  /// @brief Stores node locations and sets the locations of way nodes
+  Stage locate;
+
+  /// @brief Filters the located ways and scans them for dangerous bends
+  Stage detect;
+};
+
+/// @brief Adds the time since the previous lap to the busy or waiting time of
+/// a stage
+class StageTimer {
+ public:
+  explicit StageTimer(PipelineStats::Stage &stage);
+
+  void add_busy();
+  void add_waiting();
+
+ private:
+  auto lap() -> std::chrono::nanoseconds;
+
+  PipelineStats::Stage &stage;
+  std::chrono::steady_clock::time_point last;
+};
+
+/// @brief Buffers queued between two stages of @c run_pipeline, bounding the
+/// memory of buffers in flight
+constexpr std::size_t PIPELINE_QUEUE_SIZE = 8;
+
+/// @brief Read the objects of @p reader like
+/// `osmium::apply(reader, location_handler, handler)`, with reading, locating
+/// and detecting each on their own thread.
+///
+/// Buffers flow in order through bounded lock-free queues, so a slow stage
+/// holds back the stage before it instead of piling up buffers.
+/// @param location_handler Called on the thread of the location stage
+/// @param handler Called on the calling thread
+/// @param stats Receives the time spent by each stage
+/// @throws Rethrows the first exception thrown by a stage
+template <typename TLocationHandler, typename THandler>
+void run_pipeline(osmium::io::Reader &reader,
+                  TLocationHandler &location_handler, THandler &handler,
+                  PipelineStats &stats) {
+  SpscQueue<osmium::memory::Buffer> decoded{PIPELINE_QUEUE_SIZE};
+  SpscQueue<osmium::memory::Buffer> located{PIPELINE_QUEUE_SIZE};
+  std::exception_ptr read_error;
+  std::exception_ptr locate_error;
+
+  std::thread read_thread{[&reader, &decoded, &read_error, &stats] {
+    try {
+      StageTimer timer{stats.read};
+      while (auto buffer = reader.read()) {
+        timer.add_busy();
+        ++stats.read.buffers;
+        if (!decoded.push(std::move(buffer))) {
+          break;
+        }
+        timer.add_waiting();
+      }
+      timer.add_busy();
+    } catch (...) {
+      read_error = std::current_exception();
+    }
+    decoded.close();
+  }};
+
+  std::thread locate_thread{[&location_handler, &decoded, &located,
+                             &locate_error, &stats] {
+    try {
+      StageTimer timer{stats.locate};
+      osmium::memory::Buffer buffer;
+      while (decoded.pop(buffer)) {
+        timer.add_waiting();
+        osmium::apply(buffer, location_handler);
+        ++stats.locate.buffers;
+        timer.add_busy();
+        if (!located.push(std::move(buffer))) {
+          break;
+        }
+        timer.add_waiting();
+      }
+      timer.add_waiting();
+    } catch (...) {
+      locate_error = std::current_exception();
+    }
+    decoded.close();  // Stops the read stage early after an error
+    located.close();
+  }};
+
+  const auto join = [&] {
+    decoded.close();
+    located.close();
+    read_thread.join();
+    locate_thread.join();
+  };
+  try {
+    StageTimer timer{stats.detect};
+    osmium::memory::Buffer buffer;
+    while (located.pop(buffer)) {
+      timer.add_waiting();
+      osmium::apply(buffer, handler);
+      ++stats.detect.buffers;
+      timer.add_busy();
+    }
+    timer.add_waiting();
+  } catch (...) {
+    join();
+    throw;
+  }
+  join();
+
+  if (read_error != nullptr) {
+    std::rethrow_exception(read_error);
+  }
+  if (locate_error != nullptr) {
+    std::rethrow_exception(locate_error);
+  }
+}
+
+}  // namespace ntask
+
+#endif
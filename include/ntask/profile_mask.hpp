@@ -0,0 +1,18 @@
+#ifndef NTASK_PROFILE_MASK_HPP
+#define NTASK_PROFILE_MASK_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ntask {
+
+/// @brief Set of profiles (threshold and filter sets evaluated in the same
+/// run), bit `i` stands for profile `i`
+using ProfileMask = std::uint64_t;
+
+/// @brief Number of profiles a @c ProfileMask can hold
+constexpr std::size_t MAX_PROFILES = 64;
+
+}  // namespace ntask
+
+#endif
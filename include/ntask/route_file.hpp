@@ -0,0 +1,30 @@
+#ifndef NTASK_ROUTE_FILE_HPP
+#define NTASK_ROUTE_FILE_HPP
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "bend_index.hpp"
+
+namespace ntask {
+
+/// @brief Polyline to find the bends along
+struct Route {
+  std::string name;
+  std::vector<RoutePoint> points;
+
+  /// @brief Distance from the polyline within which bends are along the
+  /// route in meter, if given by the route file
+  std::optional<double> width;
+};
+
+/// @brief Read the routes of a GPX file (`.gpx`, every track segment and
+/// route) or a GeoJSON file (`LineString`/`MultiLineString` geometries,
+/// every line a route, with `name` and `width` of their features if set)
+/// @throws std::runtime_error If the file can not be read
+auto read_routes(const std::string &path) -> std::vector<Route>;
+
+}  // namespace ntask
+
+#endif
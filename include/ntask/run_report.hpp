@@ -0,0 +1,168 @@
+#ifndef NTASK_RUN_REPORT_HPP
+#define NTASK_RUN_REPORT_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <osmium/handler.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "pipeline.hpp"
+
+namespace ntask {
+
+/// @brief Number of objects read from the input
+struct ObjectCounts {
+  std::uint64_t node_count = 0;
+  std::uint64_t way_count = 0;
+};
+
+/// @brief Counts the objects passing through to a handler, e.g. a location
+/// handler which sees every node and way of the input
+template <typename THandler>
+class ObjectCounter : public osmium::handler::Handler {
+ public:
+  ObjectCounter(THandler &handler, ObjectCounts &counts)
+      : handler(handler), counts(counts) {}
+
+  void node(const osmium::Node &node) {
+    ++counts.node_count;
+    handler.node(node);
+  }
+
+  void way(osmium::Way &way) {
+    ++counts.way_count;
+    handler.way(way);
+  }
+
+ private:
+  THandler &handler;
+  ObjectCounts &counts;
+};
+
+/// @brief Wall and CPU time of a stage measured in many short intervals,
+/// e.g. while a handler is applied to each buffer of the input
+struct StageTime {
+  double wall_seconds = 0;
+
+  /// @brief CPU time of the measuring thread, without other threads working
+  /// for the stage
+  double cpu_seconds = 0;
+};
+
+/// @brief Adds the wall and CPU time of the calling thread from construction
+/// to destruction to a @c StageTime
+class ScopedStageTimer {
+ public:
+  explicit ScopedStageTimer(StageTime &time);
+
+  ScopedStageTimer(const ScopedStageTimer &) = delete;
+  ScopedStageTimer(ScopedStageTimer &&) = delete;
+  auto operator=(const ScopedStageTimer &) -> ScopedStageTimer & = delete;
+  auto operator=(ScopedStageTimer &&) -> ScopedStageTimer & = delete;
+
+  ~ScopedStageTimer();
+
+ private:
+  StageTime &time;
+  std::chrono::steady_clock::time_point start_time;
+  double start_cpu_seconds;
+};
+
+/// @brief Wall and CPU time per stage, counters and memory use of one run,
+/// printed for people and written as JSON for dashboards
+class RunReport {
+ public:
+  /// @brief Start measuring the run
+  RunReport();
+
+  /// @brief Stop the running stage, if any, and start measuring @p name
+  void start_stage(const std::string &name);
+
+  /// @brief Stop the running stage, if any
+  void stop_stage();
+
+  /// @brief Add a stage measured as a part of the stage @p part_of, e.g. by a
+  /// @c ScopedStageTimer
+  void add_stage(const std::string &name, const StageTime &time,
+                 const std::string &part_of);
+
+  /// @brief Add a setting of the run, e.g. the location index used
+  void add_info(const std::string &name, const std::string &value);
+
+  /// @param rate_stage Also report the count per second of wall time of this
+  /// stage, if set
+  void add_count(const std::string &name, std::uint64_t count,
+                 const std::string &rate_stage = {});
+
+  void add_memory(const std::string &name, std::uint64_t bytes);
+
+  /// @brief Add the time spent by the stages of a pipelined read
+  void add_pipeline(const PipelineStats &stats);
+
+  /// @brief Stop the running stage and take the total times, the peak
+  /// resident set size and the throughput over @p input_size bytes
+  void finish(std::uint64_t input_size);
+
+  /// @brief Print the report in human-readable form
+  void print(std::ostream &out) const;
+
+  /// @brief Write the report as JSON to @p path
+  void write_json(const std::string &path) const;
+
+ private:
+  struct Stage {
+    std::string name;
+    double wall_seconds = 0;
+    double cpu_seconds = 0;
+
+    /// @brief Stage this one is a part of, empty for a stage of the run
+    std::string part_of{};
+  };
+
+  struct Count {
+    std::string name;
+    std::uint64_t count;
+    std::optional<double> per_second;
+  };
+
+  struct Value {
+    std::string name;
+    std::string value;
+  };
+
+  struct Memory {
+    std::string name;
+    std::uint64_t bytes;
+  };
+
+  struct PipelineStage {
+    std::string name;
+    PipelineStats::Stage stats;
+  };
+
+  /// @return Wall time of the stage @p name, 0 if not measured
+  [[nodiscard]] auto get_wall_seconds(const std::string &name) const
+      -> double;
+
+  std::chrono::steady_clock::time_point start_time;
+  double start_cpu_seconds;
+  std::optional<Stage> running_stage;
+  std::chrono::steady_clock::time_point stage_start_time;
+  std::vector<Stage> stages;
+  std::vector<Value> infos;
+  std::vector<Count> counts;
+  std::vector<Memory> memories;
+  std::vector<PipelineStage> pipeline_stages;
+  Stage total{.name = "total"};
+  std::uint64_t peak_rss = 0;
+  std::uint64_t input_size = 0;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef NTASK_SPSC_QUEUE_HPP
+#define NTASK_SPSC_QUEUE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace ntask {
+
+/// @brief Bounded lock-free queue between exactly one producer thread and one
+/// consumer thread.
+///
+/// A full queue blocks the producer and an empty queue blocks the consumer,
+/// both by spinning with a growing backoff instead of a mutex. Either side
+/// may close the queue to stop the other one.
+template <typename T>
+class SpscQueue {
+ public:
+  /// @param capacity Number of items the queue holds at most, rounded up to
+  /// a power of two
+  explicit SpscQueue(std::size_t capacity)
+      : slots(std::bit_ceil(std::max(capacity, std::size_t{1}))),
+        mask(slots.size() - 1) {}
+
+  /// @brief Move @p item into the queue, waits while the queue is full
+  /// @return Whether the item was queued, false once the queue is closed
+  auto push(T &&item) -> bool {
+    const auto tail_index = tail.load(std::memory_order_relaxed);
+    Backoff backoff;
+    while (tail_index - head.load(std::memory_order_acquire) == slots.size()) {
+      if (closed.load(std::memory_order_acquire)) {
+        return false;
+      }
+      backoff.pause();
+    }
+    slots[tail_index & mask] = std::move(item);
+    tail.store(tail_index + 1, std::memory_order_release);
+    return !closed.load(std::memory_order_acquire);
+  }
+
+  /// @brief Move the oldest item out of the queue, waits while the queue is
+  /// empty
+  /// @return Whether an item was taken, false once the queue is closed and
+  /// empty
+  auto pop(T &item) -> bool {
+    const auto head_index = head.load(std::memory_order_relaxed);
+    Backoff backoff;
+    while (tail.load(std::memory_order_acquire) == head_index) {
+      if (closed.load(std::memory_order_acquire)) {
+        // Items pushed right before closing are still taken
+        if (tail.load(std::memory_order_acquire) == head_index) {
+          return false;
+        }
+        break;
+      }
+      backoff.pause();
+    }
+    item = std::move(slots[head_index & mask]);
+    head.store(head_index + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Wake and stop the other side, a producer after the last item or
+  /// a consumer giving up
+  void close() noexcept { closed.store(true, std::memory_order_release); }
+
+ private:
+  /// @brief Waits of a blocked side, spinning first for short waits and
+  /// sleeping for long ones
+  class Backoff {
+   public:
+    void pause() {
+      constexpr unsigned SPIN_COUNT = 64;
+      constexpr unsigned YIELD_COUNT = 128;
+      constexpr std::chrono::microseconds SLEEP_TIME{50};
+      if (count < SPIN_COUNT) {
+        ++count;
+      } else if (count < YIELD_COUNT) {
+        ++count;
+        std::this_thread::yield();
+      } else {
+        std::this_thread::sleep_for(SLEEP_TIME);
+      }
+    }
+
+   private:
+    unsigned count = 0;
+  };
+
+  /// @brief Keeps the indices written by different threads on different
+  /// cache lines
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  std::vector<T> slots;
+  const std::size_t mask;
+
+  /// @brief Index of the next item to pop, only written by the consumer
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head{0};
+
+  /// @brief Index of the next item to push, only written by the producer
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail{0};
+
+  alignas(CACHE_LINE_SIZE) std::atomic<bool> closed{false};
+};
+
+}  // namespace ntask
+
+#endif
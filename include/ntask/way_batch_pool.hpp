@@ -0,0 +1,100 @@
+#ifndef NTASK_WAY_BATCH_POOL_HPP
+#define NTASK_WAY_BATCH_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "bend_detector.hpp"
+
+namespace ntask {
+
+/// @brief Ways handed to a worker of @c WayBatchPool at once
+struct WayBatch {
+  /// @brief Owns the ways whose nodes are referenced by @c ways, if any
+  osmium::memory::Buffer buffer;
+
+  /// @brief Nodes of each way of the batch
+  std::vector<std::span<const osmium::NodeRef>> ways;
+
+  /// @brief Profiles to scan each way of the batch for
+  std::vector<ProfileMask> profiles;
+
+  /// @brief ID of each way of the batch, set on its bends
+  std::vector<osmium::object_id_type> way_ids;
+};
+
+/// @brief Scans batches of ways for dangerous bends on a set of worker
+/// threads.
+///
+/// Every worker has its own detector and result vector. The results are
+/// handed out batch by batch in submission order, so they do not depend on
+/// the number of threads or on scheduling.
+class WayBatchPool {
+ public:
+  /// @param detector Copied to every worker
+  /// @param thread_count Number of worker threads
+  WayBatchPool(const BendDetector &detector, std::size_t thread_count);
+
+  WayBatchPool(const WayBatchPool &) = delete;
+  WayBatchPool(WayBatchPool &&) = delete;
+  auto operator=(const WayBatchPool &) -> WayBatchPool & = delete;
+  auto operator=(WayBatchPool &&) -> WayBatchPool & = delete;
+
+  ~WayBatchPool();
+
+  /// @brief Queue a batch, blocks while all workers are busy and the queue
+  /// is full
+  /// @throws Rethrows the first exception thrown by a worker
+  void submit(WayBatch batch);
+
+  /// @brief Take the results of the batches scanned so far, without waiting
+  /// @return Dangerous bends of each batch in submission order, up to the
+  /// first batch not scanned yet
+  auto take_completed() -> std::vector<std::vector<BendDetector::Bend>>;
+
+  /// @brief Wait until all batches are scanned and stop the workers
+  /// @return Dangerous bends of each batch not taken yet in submission order
+  /// @throws Rethrows the first exception thrown by a worker
+  auto finish() -> std::vector<std::vector<BendDetector::Bend>>;
+
+  /// @return Work done by all workers, complete after @c finish
+  [[nodiscard]] auto get_counters() const -> BendDetector::Counters;
+
+ private:
+  struct Worker {
+    BendDetector detector;
+    std::vector<BendDetector::Bend> dangerous_bends;
+  };
+
+  void work(Worker &worker);
+  void stop();
+
+  std::vector<Worker> workers;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex;
+  std::condition_variable queue_changed;
+  std::deque<std::pair<std::size_t, WayBatch>> queue;
+  std::size_t queue_capacity;
+  std::size_t next_sequence = 0;
+
+  /// @brief Results of scanned batches by sequence number, waiting for the
+  /// batches before them
+  std::map<std::size_t, std::vector<BendDetector::Bend>> completed;
+  std::size_t next_completed = 0;
+
+  bool stopped = false;
+  std::exception_ptr error;
+};
+
+}  // namespace ntask
+
+#endif
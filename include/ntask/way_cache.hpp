@@ -0,0 +1,133 @@
+#ifndef NTASK_WAY_CACHE_HPP
+#define NTASK_WAY_CACHE_HPP
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <osmium/handler.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/way.hpp>
+#include <osmium/util/memory_mapping.hpp>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "way_filter.hpp"
+
+namespace ntask {
+
+/// @brief Identifies the input a way cache was built from. A cache is only
+/// reused when all fields match.
+struct WayCacheKey {
+  /// @brief Hash of the input file content
+  std::uint64_t input_hash;
+
+  /// @brief Modification time of the input file (file clock ticks)
+  std::int64_t input_mtime;
+
+  /// @brief Hash of the way filters of all profiles and of the boundary, a
+  /// cache only holds the ways they accepted
+  std::uint64_t filter_hash;
+
+  /// @brief Compute the key of an input file and the way filters of its
+  /// profiles
+  /// @param boundary_hash Hash of the boundary the input is read within, 0
+  /// without a boundary
+  static auto make(const std::string &input_file,
+                   const std::vector<FilterRules> &profiles,
+                   std::uint64_t boundary_hash) -> WayCacheKey;
+
+  /// @return Hash of the way filters of all profiles
+  static auto hash_filters(const std::vector<FilterRules> &profiles)
+      -> std::uint64_t;
+
+  auto operator==(const WayCacheKey &other) const -> bool = default;
+};
+
+/// @brief Memory mapped cache of the filtered ways of an input file with
+/// their resolved node locations.
+///
+/// Layout (native byte order): a fixed size header, all node refs of all ways
+/// back to back, the way IDs, the profiles accepting each way and
+/// `way_count + 1` offsets into the node refs.
+class WayCache {
+ public:
+  /// @brief Map a cache file
+  /// @return Nothing if the file does not exist, is not a way cache of this
+  /// version or was built for another @p key
+  static auto load(const std::string &path, const WayCacheKey &key)
+      -> std::optional<WayCache>;
+
+  /// @return Number of cached ways
+  [[nodiscard]] auto size() const noexcept -> std::size_t;
+
+  /// @return ID of the way at @p index
+  [[nodiscard]] auto way_id(std::size_t index) const noexcept
+      -> osmium::object_id_type;
+
+  /// @return Nodes of the way at @p index with their locations
+  [[nodiscard]] auto nodes(std::size_t index) const noexcept
+      -> std::span<const osmium::NodeRef>;
+
+  /// @return Profiles whose filters the way at @p index passed
+  [[nodiscard]] auto profiles(std::size_t index) const noexcept
+      -> ProfileMask;
+
+ private:
+  friend class WayCacheWriter;
+
+  struct Header {
+    std::array<char, 8> magic;
+    std::uint64_t version;
+    WayCacheKey key;
+    std::uint64_t way_count;
+    std::uint64_t node_count;
+  };
+
+  static constexpr std::array<char, 8> MAGIC{'N', 'T', 'W', 'C',
+                                             'A', 'C', 'H', 'E'};
+  static constexpr std::uint64_t VERSION = 2;
+
+  WayCache(osmium::util::MemoryMapping mapping, const Header &header);
+
+  osmium::util::MemoryMapping mapping;
+  std::span<const osmium::NodeRef> node_refs;
+  std::span<const osmium::object_id_type> way_ids;
+  std::span<const ProfileMask> way_profiles;
+  std::span<const std::uint64_t> offsets;
+};
+
+/// @brief Handler writing the ways accepted by a @c WayFilter to a
+/// @c WayCache file with the profiles accepting them. Ways must already have
+/// their node locations set.
+///
+/// The cache is written to a temporary file which only replaces @p path in
+/// @c close, so an interrupted run never leaves a truncated cache behind.
+class WayCacheWriter : public osmium::handler::Handler {
+ public:
+  WayCacheWriter(std::string path, const WayCacheKey &key,
+                 const WayFilter &way_filter);
+
+  void way(const osmium::Way &way);
+
+  /// @brief Write the way index and header and move the cache into place
+  void close();
+
+ private:
+  void write(std::span<const char> bytes);
+
+  std::string path;
+  std::string temporary_path;
+  std::ofstream file;
+  const WayFilter &way_filter;
+  WayCache::Header header;
+  std::vector<osmium::object_id_type> way_ids;
+  std::vector<ProfileMask> way_profiles;
+  std::vector<std::uint64_t> offsets;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef NTASK_WAY_FILTER_HPP
+#define NTASK_WAY_FILTER_HPP
+
+#include <bitset>
+#include <functional>
+#include <osmium/osm/way.hpp>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "profile_mask.hpp"
+
+namespace ntask {
+
+/// @brief Tag rule of a way filter (e.g. `oneway=yes`)
+struct TagRule {
+  /// @brief How the value of a tag is matched
+  enum class Match {
+    /// @brief Equal to @c value
+    value,
+
+    /// @brief Any value, the key is enough
+    any_value,
+
+    /// @brief The whole value matches the regular expression in @c value
+    value_regex
+  };
+
+  std::string key;
+  std::string value;
+  Match match = Match::value;
+};
+
+/// @brief Filter rules of one profile
+struct FilterRules {
+  /// @brief Ways without any of these values assigned to the key `highway`
+  /// are rejected
+  std::vector<std::string> highway_tags;
+
+  /// @brief Ways with a tag matching any of these rules are rejected
+  std::vector<TagRule> blacklisted_tags;
+};
+
+/// @brief Decides which ways are roads worth scanning for dangerous bends,
+/// for up to @c MAX_PROFILES profiles at once.
+///
+/// The rules of all profiles are compiled once into a table by key holding
+/// the profiles each rule applies to, so a way is checked against every
+/// profile in a single pass over its tags. Keys are first screened by their
+/// first byte, which rejects most tags of most ways without hashing them.
+class WayFilter {
+ public:
+  /// @param highway_tags Ways without any of these values assigned to the key
+  /// `highway` will be rejected
+  /// @param blacklisted_tags Ways with a tag matching any of these rules will
+  /// be rejected
+  WayFilter(const std::vector<std::string> &highway_tags,
+            const std::vector<TagRule> &blacklisted_tags);
+
+  /// @param profiles Rules of each profile
+  /// @throws std::runtime_error With more than @c MAX_PROFILES profiles
+  explicit WayFilter(const std::vector<FilterRules> &profiles);
+
+  /// @return Profiles whose highway and blacklist filters @p way passes
+  [[nodiscard]] auto match(const osmium::Way &way) const -> ProfileMask;
+
+  /// @return Whether @p way passes the filters of any profile
+  [[nodiscard]] auto accepts(const osmium::Way &way) const -> bool;
+
+ private:
+  struct StringHash {
+    using is_transparent = void;
+
+    auto operator()(std::string_view value) const noexcept -> std::size_t {
+      return std::hash<std::string_view>{}(value);
+    }
+  };
+
+  /// @brief Profiles of each value
+  using ValueMasks = std::unordered_map<std::string, ProfileMask, StringHash,
+                                        std::equal_to<>>;
+
+  /// @brief All rules for one key
+  struct KeyRules {
+    ProfileMask blacklists_any_value = 0;
+    ValueMasks blacklisted_values;
+    std::vector<std::pair<std::regex, ProfileMask>> blacklisted_regexes;
+  };
+
+  static auto get_mask(const ValueMasks &masks, std::string_view value)
+      -> ProfileMask;
+
+  static constexpr std::size_t BYTE_VALUES = 256;
+
+  std::unordered_map<std::string, KeyRules, StringHash, std::equal_to<>>
+      key_rules;
+  ValueMasks highway_values;
+  ProfileMask all_profiles = 0;
+  std::bitset<BYTE_VALUES> first_key_bytes;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef NTASK_WAY_NODES_HPP
+#define NTASK_WAY_NODES_HPP
+
+#include <osmium/handler.hpp>
+#include <osmium/index/id_set.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+
+#include "way_filter.hpp"
+
+namespace ntask {
+
+/// @brief Set of node IDs, one bit per possible ID
+using NodeIdSet = osmium::index::IdSetDense<osmium::unsigned_object_id_type>;
+
+/// @brief First pass of the two-pass mode: collects the IDs of nodes
+/// referenced by ways accepted by a @c WayFilter
+class WayNodeCollector : public osmium::handler::Handler {
+ public:
+  explicit WayNodeCollector(const WayFilter &way_filter);
+
+  void way(const osmium::Way &way);
+
+  /// @return IDs of the nodes needed by the accepted ways
+  [[nodiscard]] auto get_node_ids() const noexcept -> const NodeIdSet &;
+
+ private:
+  const WayFilter &way_filter;
+  NodeIdSet node_ids;
+};
+
+/// @brief Second pass of the two-pass mode: forwards to a location handler
+/// only the nodes collected by @c WayNodeCollector
+/// @note The wrapped handler should ignore errors, ways rejected by the filter
+/// may reference nodes whose location was never stored
+template <typename TLocationHandler>
+class FilteredNodeLocations : public osmium::handler::Handler {
+ public:
+  FilteredNodeLocations(TLocationHandler &location_handler,
+                        const NodeIdSet &node_ids)
+      : location_handler(location_handler), node_ids(node_ids) {}
+
+  void node(const osmium::Node &node) {
+    if (node_ids.get(node.positive_id())) {
+      location_handler.node(node);
+    }
+  }
+
+  void way(osmium::Way &way) { location_handler.way(way); }
+
+ private:
+  TLocationHandler &location_handler;
+  const NodeIdSet &node_ids;
+};
+
+}  // namespace ntask
+
+#endif
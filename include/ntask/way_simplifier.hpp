@@ -0,0 +1,60 @@
+#ifndef NTASK_WAY_SIMPLIFIER_HPP
+#define NTASK_WAY_SIMPLIFIER_HPP
+
+#include <cstdint>
+#include <osmium/osm/node_ref.hpp>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace ntask {
+
+/// @brief Simplifies the geometry of ways with the Douglas-Peucker algorithm,
+/// so that no left out node is farther than the tolerance from the
+/// simplified way.
+///
+/// Distances of a node are measured on an equirectangular projection at its
+/// own latitude, which is exact near the node whatever the length of the way
+/// and its span of latitudes.
+///
+/// Kept nodes keep their IDs. Nodes without a valid location are always
+/// kept, the runs of valid nodes between them are simplified on their own.
+/// @note Keeps scratch memory between calls, use one simplifier per thread
+class WaySimplifier {
+ public:
+  /// @param tolerance Largest distance in meter of a left out node from the
+  /// simplified way
+  explicit WaySimplifier(double tolerance);
+
+  /// @return Kept nodes of @p nodes in order, valid until the next call
+  auto simplify(std::span<const osmium::NodeRef> nodes)
+      -> std::span<const osmium::NodeRef>;
+
+ private:
+  /// @brief Node of the current way, see @c BendDetector::ProjectedNode
+  struct Point {
+    /// @brief Longitude in radian times earth radius
+    double x;
+
+    /// @brief Latitude in radian times earth radius
+    double y;
+
+    /// @brief Cosine of the latitude, scale of @c x at this node
+    double scale;
+  };
+
+  /// @brief Mark the nodes to keep of the valid run from @p begin to
+  /// @p end (exclusive)
+  void simplify_run(std::span<const osmium::NodeRef> nodes, std::size_t begin,
+                    std::size_t end);
+
+  double tolerance_squared;
+  std::vector<Point> points;
+  std::vector<std::uint8_t> keep;
+  std::vector<std::pair<std::size_t, std::size_t>> ranges;
+  std::vector<osmium::NodeRef> simplified;
+};
+
+}  // namespace ntask
+
+#endif
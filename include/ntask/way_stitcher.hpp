@@ -0,0 +1,137 @@
+#ifndef NTASK_WAY_STITCHER_HPP
+#define NTASK_WAY_STITCHER_HPP
+
+#include <cstdint>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <osmium/osm/tag.hpp>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "profile_mask.hpp"
+
+namespace ntask {
+
+/// @brief Finds dangerous bends at the node shared by the ends of two ways
+/// continuing each other, e.g. a road split at a bridge.
+///
+/// The detector only sees one way at a time, so the end node of a way never
+/// has neighbours on both sides. Ways continue each other if they end at the
+/// same node and have the same `highway`, `ref` and `name`; a closed way
+/// continues itself. For every end of a way the nodes within the largest
+/// distance threshold (at most @c MAX_TAIL_NODES) wait for the continuing
+/// way, then the node is scanned with the nodes of both ways around it.
+///
+/// Ends of different roads meeting at a node wait side by side. Memory is
+/// bounded: at most @c max_endpoints ends wait at a time, the oldest are
+/// dropped beyond that and their bends are missed.
+class WayStitcher {
+ public:
+  /// @brief Nodes kept of an end of a way, with the end node
+  static constexpr std::size_t MAX_TAIL_NODES = 8;
+
+  /// @brief What happened to the ends of the ways
+  struct Counters {
+    /// @brief Ends added to wait for their continuing way
+    std::uint64_t endpoint_count = 0;
+
+    /// @brief Ends met by their continuing way and scanned
+    std::uint64_t junction_count = 0;
+
+    /// @brief Ends dropped without being scanned: waiting ends dropped to
+    /// stay within the memory bound, and ends meeting a waiting end of the
+    /// same road accepted by none of their profiles
+    std::uint64_t dropped_count = 0;
+  };
+
+  /// @param profiles Thresholds of each profile
+  /// @param distance_model How to measure distances between nodes
+  /// @param max_endpoints Ends of ways waiting at most
+  WayStitcher(const std::vector<BendDetector::Thresholds> &profiles,
+              BendDetector::DistanceModel distance_model,
+              std::size_t max_endpoints);
+
+  /// @return Hash of the tags two continuing ways share
+  static auto get_key(const osmium::TagList &tags) -> std::uint64_t;
+
+  /// @brief Stitch the ends of a way to the waiting ends of continuing ways
+  /// and keep the others waiting
+  /// @param way_id ID of the way, set on the bends found at its ends
+  /// @param nodes Nodes of the way with their locations
+  /// @param profiles Profiles whose filters the way passed
+  /// @param key Key of the way, see @c get_key
+  /// @param dangerous_bends Bends found at the ends of the way are appended
+  /// here
+  void add(osmium::object_id_type way_id,
+           std::span<const osmium::NodeRef> nodes, ProfileMask profiles,
+           std::uint64_t key, std::vector<BendDetector::Bend> &dangerous_bends);
+
+  [[nodiscard]] auto get_counters() const noexcept -> const Counters &;
+
+  /// @return Distances measured and angles evaluated at the ends of ways
+  [[nodiscard]] auto get_detector_counters() const noexcept
+      -> const BendDetector::Counters &;
+
+  /// @return Bytes allocated for the waiting ends
+  [[nodiscard]] auto used_memory() const -> std::size_t;
+
+ private:
+  /// @brief End of a way waiting for its continuing way
+  struct Endpoint {
+    osmium::object_id_type node_id;
+    std::uint64_t key;
+    ProfileMask profiles;
+
+    /// @brief Number of nodes of the tail, from the end node inwards
+    std::uint32_t tail_size;
+  };
+
+  /// @brief Collect the end node of @p nodes and the nodes after it into
+  /// @c tail, the window of the end node
+  void collect_tail(std::span<const osmium::NodeRef> nodes, bool forward);
+
+  /// @brief Waiting end of a road at a node
+  struct SlotKey {
+    osmium::object_id_type node_id;
+    std::uint64_t key;
+
+    auto operator==(const SlotKey &other) const -> bool = default;
+  };
+
+  struct SlotKeyHash {
+    auto operator()(const SlotKey &slot_key) const noexcept -> std::size_t;
+  };
+
+  /// @brief Stitch @c tail to a waiting end or keep it waiting
+  void add_endpoint(osmium::object_id_type way_id,
+                    const osmium::NodeRef &node, ProfileMask profiles,
+                    std::uint64_t key,
+                    std::vector<BendDetector::Bend> &dangerous_bends);
+
+  BendDetector detector;
+  double max_distance = 0;
+  std::size_t max_endpoints;
+
+  /// @brief Ring of the waiting ends, the slot after the last written is
+  /// overwritten next
+  std::vector<Endpoint> endpoints;
+
+  /// @brief Tails of the slots of @c endpoints, @c MAX_TAIL_NODES each
+  std::vector<osmium::Location> tails;
+
+  std::size_t next_slot = 0;
+
+  /// @brief Slot of each waiting end by its node and road
+  std::unordered_map<SlotKey, std::size_t, SlotKeyHash> slots;
+
+  std::vector<osmium::Location> tail;
+  std::vector<osmium::Location> stitched;
+  std::vector<BendDetector::Bend> stitched_bends;
+  Counters counters;
+};
+
+}  // namespace ntask
+
+#endif
@@ -0,0 +1,250 @@
+#include "angle_kernel.hpp"
+
+#include <array>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NTASK_X86
+#endif
+
+// Vectorized implementations must not be contracted to FMA, they would not
+// round like the scalar one anymore (see CMakeLists.txt).
+// NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+using ntask::AngleKernel;
+
+namespace {
+
+constexpr double NO_COSINE = -std::numeric_limits<double>::infinity();
+
+// The scalar loops also handle the tails of the vectorized ones and are
+// always inlined there: calling non-VEX code with dirty upper AVX registers
+// costs hundreds of cycles per call on some CPUs.
+[[gnu::always_inline]] inline auto max_valid(double max_cosine, double cosine)
+    -> double {
+  return cosine > max_cosine && cosine <= 1.0 && cosine >= -1.0 ? cosine
+                                                               : max_cosine;
+}
+
+[[gnu::always_inline]] inline auto max_cosine_by_sides_scalar(
+    double dist_b, std::span<const double> dist_a,
+    std::span<const double> dist_c, std::size_t begin, double max_cosine)
+    -> double {
+  for (auto index = begin; index < dist_a.size(); ++index) {
+    max_cosine = max_valid(
+        max_cosine, ((dist_a[index] * dist_a[index]) + (dist_b * dist_b) -
+                     (dist_c[index] * dist_c[index])) /
+                        (2 * dist_a[index] * dist_b));
+  }
+  return max_cosine;
+}
+
+[[gnu::always_inline]] inline auto max_cosine_by_vectors_scalar(
+    double x, double y, double norm, std::span<const double> xs,
+    std::span<const double> ys, std::span<const double> norms,
+    std::size_t begin, double max_cosine) -> double {
+  for (auto index = begin; index < xs.size(); ++index) {
+    max_cosine = max_valid(max_cosine, ((x * xs[index]) + (y * ys[index])) /
+                                           (norm * norms[index]));
+  }
+  return max_cosine;
+}
+
+auto max_cosine_by_sides(double dist_b, std::span<const double> dist_a,
+                         std::span<const double> dist_c) -> double {
+  return max_cosine_by_sides_scalar(dist_b, dist_a, dist_c, 0, NO_COSINE);
+}
+
+auto max_cosine_by_vectors(double x, double y, double norm,
+                           std::span<const double> xs,
+                           std::span<const double> ys,
+                           std::span<const double> norms) -> double {
+  return max_cosine_by_vectors_scalar(x, y, norm, xs, ys, norms, 0,
+                                      NO_COSINE);
+}
+
+#ifdef NTASK_X86
+
+constexpr std::size_t AVX2_WIDTH = 4;
+constexpr std::size_t AVX512_WIDTH = 8;
+
+__attribute__((target("avx2"))) auto max_valid_avx2(__m256d max_cosine,
+                                                    __m256d cosine)
+    -> __m256d {
+  const auto valid =
+      _mm256_and_pd(_mm256_cmp_pd(cosine, _mm256_set1_pd(1.0), _CMP_LE_OQ),
+                    _mm256_cmp_pd(cosine, _mm256_set1_pd(-1.0), _CMP_GE_OQ));
+  return _mm256_max_pd(max_cosine,
+                       _mm256_blendv_pd(_mm256_set1_pd(NO_COSINE), cosine,
+                                        valid));
+}
+
+__attribute__((target("avx2"))) auto reduce_max_avx2(__m256d values)
+    -> double {
+  std::array<double, AVX2_WIDTH> lanes{};
+  _mm256_storeu_pd(lanes.data(), values);
+  auto max_value = NO_COSINE;
+  for (const auto lane : lanes) {
+    max_value = lane > max_value ? lane : max_value;
+  }
+  return max_value;
+}
+
+__attribute__((target("avx2"))) auto max_cosine_by_sides_avx2(
+    double dist_b, std::span<const double> dist_a,
+    std::span<const double> dist_c) -> double {
+  const auto b = _mm256_set1_pd(dist_b);
+  const auto b_square = _mm256_mul_pd(b, b);
+  const auto two = _mm256_set1_pd(2);
+  auto max_cosine = _mm256_set1_pd(NO_COSINE);
+  std::size_t index = 0;
+  for (; index + AVX2_WIDTH <= dist_a.size(); index += AVX2_WIDTH) {
+    const auto a = _mm256_loadu_pd(dist_a.data() + index);
+    const auto c = _mm256_loadu_pd(dist_c.data() + index);
+    const auto numerator = _mm256_sub_pd(
+        _mm256_add_pd(_mm256_mul_pd(a, a), b_square), _mm256_mul_pd(c, c));
+    const auto denominator = _mm256_mul_pd(_mm256_mul_pd(two, a), b);
+    max_cosine =
+        max_valid_avx2(max_cosine, _mm256_div_pd(numerator, denominator));
+  }
+  return max_cosine_by_sides_scalar(dist_b, dist_a, dist_c, index,
+                                    reduce_max_avx2(max_cosine));
+}
+
+__attribute__((target("avx2"))) auto max_cosine_by_vectors_avx2(
+    double x, double y, double norm, std::span<const double> xs,
+    std::span<const double> ys, std::span<const double> norms) -> double {
+  const auto left_x = _mm256_set1_pd(x);
+  const auto left_y = _mm256_set1_pd(y);
+  const auto left_norm = _mm256_set1_pd(norm);
+  auto max_cosine = _mm256_set1_pd(NO_COSINE);
+  std::size_t index = 0;
+  for (; index + AVX2_WIDTH <= xs.size(); index += AVX2_WIDTH) {
+    const auto dot = _mm256_add_pd(
+        _mm256_mul_pd(left_x, _mm256_loadu_pd(xs.data() + index)),
+        _mm256_mul_pd(left_y, _mm256_loadu_pd(ys.data() + index)));
+    const auto norm_product =
+        _mm256_mul_pd(left_norm, _mm256_loadu_pd(norms.data() + index));
+    max_cosine = max_valid_avx2(max_cosine, _mm256_div_pd(dot, norm_product));
+  }
+  return max_cosine_by_vectors_scalar(x, y, norm, xs, ys, norms, index,
+                                      reduce_max_avx2(max_cosine));
+}
+
+__attribute__((target("avx512f"))) auto max_valid_avx512(__m512d max_cosine,
+                                                         __m512d cosine)
+    -> __m512d {
+  const auto valid =
+      _mm512_cmp_pd_mask(cosine, _mm512_set1_pd(1.0), _CMP_LE_OQ) &
+      _mm512_cmp_pd_mask(cosine, _mm512_set1_pd(-1.0), _CMP_GE_OQ);
+  return _mm512_mask_max_pd(max_cosine, valid, max_cosine, cosine);
+}
+
+// Not _mm512_reduce_max_pd(), GCC warns about the undefined upper half it
+// extracts with optimizations on
+__attribute__((target("avx512f"))) auto reduce_max_avx512(__m512d values)
+    -> double {
+  std::array<double, AVX512_WIDTH> lanes{};
+  _mm512_storeu_pd(lanes.data(), values);
+  auto max_value = NO_COSINE;
+  for (const auto lane : lanes) {
+    max_value = lane > max_value ? lane : max_value;
+  }
+  return max_value;
+}
+
+__attribute__((target("avx512f"))) auto max_cosine_by_sides_avx512(
+    double dist_b, std::span<const double> dist_a,
+    std::span<const double> dist_c) -> double {
+  const auto b = _mm512_set1_pd(dist_b);
+  const auto b_square = _mm512_mul_pd(b, b);
+  const auto two = _mm512_set1_pd(2);
+  auto max_cosine = _mm512_set1_pd(NO_COSINE);
+  std::size_t index = 0;
+  for (; index + AVX512_WIDTH <= dist_a.size(); index += AVX512_WIDTH) {
+    const auto a = _mm512_loadu_pd(dist_a.data() + index);
+    const auto c = _mm512_loadu_pd(dist_c.data() + index);
+    const auto numerator = _mm512_sub_pd(
+        _mm512_add_pd(_mm512_mul_pd(a, a), b_square), _mm512_mul_pd(c, c));
+    const auto denominator = _mm512_mul_pd(_mm512_mul_pd(two, a), b);
+    max_cosine =
+        max_valid_avx512(max_cosine, _mm512_div_pd(numerator, denominator));
+  }
+  return max_cosine_by_sides_scalar(dist_b, dist_a, dist_c, index,
+                                    reduce_max_avx512(max_cosine));
+}
+
+__attribute__((target("avx512f"))) auto max_cosine_by_vectors_avx512(
+    double x, double y, double norm, std::span<const double> xs,
+    std::span<const double> ys, std::span<const double> norms) -> double {
+  const auto left_x = _mm512_set1_pd(x);
+  const auto left_y = _mm512_set1_pd(y);
+  const auto left_norm = _mm512_set1_pd(norm);
+  auto max_cosine = _mm512_set1_pd(NO_COSINE);
+  std::size_t index = 0;
+  for (; index + AVX512_WIDTH <= xs.size(); index += AVX512_WIDTH) {
+    const auto dot = _mm512_add_pd(
+        _mm512_mul_pd(left_x, _mm512_loadu_pd(xs.data() + index)),
+        _mm512_mul_pd(left_y, _mm512_loadu_pd(ys.data() + index)));
+    const auto norm_product =
+        _mm512_mul_pd(left_norm, _mm512_loadu_pd(norms.data() + index));
+    max_cosine =
+        max_valid_avx512(max_cosine, _mm512_div_pd(dot, norm_product));
+  }
+  return max_cosine_by_vectors_scalar(x, y, norm, xs, ys, norms, index,
+                                      reduce_max_avx512(max_cosine));
+}
+
+#endif
+
+constexpr AngleKernel SCALAR_KERNEL{
+    .name = "scalar",
+    .max_cosine_by_sides = max_cosine_by_sides,
+    .max_cosine_by_vectors = max_cosine_by_vectors};
+
+#ifdef NTASK_X86
+constexpr AngleKernel AVX2_KERNEL{
+    .name = "avx2",
+    .max_cosine_by_sides = max_cosine_by_sides_avx2,
+    .max_cosine_by_vectors = max_cosine_by_vectors_avx2};
+
+constexpr AngleKernel AVX512_KERNEL{
+    .name = "avx512",
+    .max_cosine_by_sides = max_cosine_by_sides_avx512,
+    .max_cosine_by_vectors = max_cosine_by_vectors_avx512};
+#endif
+
+}  // namespace
+
+// NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+auto AngleKernel::get() -> const AngleKernel & {
+  static const AngleKernel &kernel = []() -> const AngleKernel & {
+#ifdef NTASK_X86
+    if (const auto *kernel = find(AVX512_KERNEL.name)) {
+      return *kernel;
+    }
+    if (const auto *kernel = find(AVX2_KERNEL.name)) {
+      return *kernel;
+    }
+#endif
+    return SCALAR_KERNEL;
+  }();
+  return kernel;
+}
+
+auto AngleKernel::find(std::string_view name) -> const AngleKernel * {
+  if (name == SCALAR_KERNEL.name) {
+    return &SCALAR_KERNEL;
+  }
+#ifdef NTASK_X86
+  if (name == AVX2_KERNEL.name && __builtin_cpu_supports("avx2")) {
+    return &AVX2_KERNEL;
+  }
+  if (name == AVX512_KERNEL.name && __builtin_cpu_supports("avx512f")) {
+    return &AVX512_KERNEL;
+  }
+#endif
+  return nullptr;
+}
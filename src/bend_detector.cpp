@@ -0,0 +1,411 @@
+#include "bend_detector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <osmium/geom/haversine.hpp>
+#include <stdexcept>
+#include <string>
+
+using ntask::BendDetector;
+
+namespace {
+
+/// @brief Angle in radian kept between the turning of a skipped way and the
+/// angle threshold, far above the error of headings and angles taken on
+/// different projections of the sphere
+constexpr double TURN_MARGIN = osmium::geom::PI / 180;
+
+/// @brief Relative margin on the length of the stretches a window can span
+constexpr double SPAN_MARGIN = 1.02;
+
+/// @brief Ways with nodes beyond this latitude are always scanned, the
+/// headings of the equirectangular projection distort too much there
+constexpr double MAX_SKIP_LATITUDE = 70;
+
+}  // namespace
+
+BendDetector::BendDetector(double distance_threshold, double angle_threshold,
+                           DistanceModel distance_model)
+    : BendDetector(std::vector<Thresholds>{Thresholds{
+                       .distance_threshold = distance_threshold,
+                       .angle_threshold = angle_threshold}},
+                   distance_model) {}
+
+BendDetector::BendDetector(const std::vector<Thresholds> &profiles,
+                           DistanceModel distance_model,
+                           double simplify_tolerance)
+    : distance_model(distance_model), angle_kernel(AngleKernel::get()) {
+  if (simplify_tolerance != 0) {
+    simplifier.emplace(simplify_tolerance);
+  }
+  if (profiles.size() > MAX_PROFILES) {
+    throw std::runtime_error("At most " + std::to_string(MAX_PROFILES) +
+                             " profiles are supported");
+  }
+  for (const auto &thresholds : profiles) {
+    // While the way turns less than max_turn, a window reaches at most
+    // 1 / cos(max_turn / 2) times the distance threshold along the way on
+    // each side of its node (see is_free_of_bends)
+    const auto max_turn = get_max_turn(thresholds.angle_threshold);
+    this->profiles.push_back(Profile{
+        .distance_threshold = thresholds.distance_threshold,
+        .cos_threshold = get_cos_threshold(thresholds.angle_threshold),
+        .max_turn = max_turn,
+        .turn_span = 2 * SPAN_MARGIN * thresholds.distance_threshold /
+                     std::cos(max_turn / 2)});
+  }
+}
+
+void BendDetector::detect(std::span<const osmium::NodeRef> nodes,
+                          std::vector<osmium::NodeRef> &dangerous_bends) {
+  profile_bends.clear();
+  detect(nodes, 1, profile_bends);
+  for (const auto &bend : profile_bends) {
+    dangerous_bends.push_back(bend.node);
+  }
+}
+
+void BendDetector::detect(std::span<const osmium::NodeRef> nodes,
+                          ProfileMask profiles,
+                          std::vector<Bend> &dangerous_bends) {
+  // The window of the largest distance threshold holds the windows of all
+  // other profiles
+  active_profiles.clear();
+  double window_threshold = -std::numeric_limits<double>::infinity();
+  auto max_turn = std::numeric_limits<double>::infinity();
+  double turn_span = 0;
+  for (std::size_t profile = 0; profile < this->profiles.size(); ++profile) {
+    if ((profiles & (ProfileMask{1} << profile)) != 0) {
+      active_profiles.push_back(profile);
+      const auto &thresholds = this->profiles[profile];
+      window_threshold =
+          std::max(window_threshold, thresholds.distance_threshold);
+      max_turn = std::min(max_turn, thresholds.max_turn);
+      turn_span = std::max(turn_span, thresholds.turn_span);
+    }
+  }
+  if (active_profiles.empty()) {
+    return;
+  }
+
+  ++counters.way_count;
+  const auto bend_count = dangerous_bends.size();
+  if (simplifier) {
+    const auto node_count = nodes.size();
+    nodes = simplifier->simplify(nodes);
+    counters.simplified_node_count += node_count - nodes.size();
+  }
+  if (curvature_check && max_turn > 0 &&
+      is_free_of_bends(nodes, max_turn, turn_span)) {
+    ++counters.skipped_way_count;
+    return;
+  }
+  reset(nodes);
+  for (std::size_t node_index = 0; node_index < nodes.size(); ++node_index) {
+    std::size_t left_begin = node_index;
+    while (left_begin > 0) {
+      if (get_distance(left_begin - 1, node_index) > window_threshold) {
+        break;
+      }
+      --left_begin;
+    }
+
+    right_distances.clear();
+    for (auto right_node_index = node_index + 1;
+         right_node_index < nodes.size(); ++right_node_index) {
+      const auto distance = get_distance(node_index, right_node_index);
+      if (distance > window_threshold) {
+        break;
+      }
+
+      right_distances.push_back(distance);
+    }
+
+    if (left_begin == node_index || right_distances.empty()) {
+      continue;
+    }
+
+    if (distance_model == DistanceModel::planar) {
+      load_vectors(node_index, left_begin,
+                   node_index + right_distances.size());
+    }
+
+    for (const auto profile : active_profiles) {
+      const auto &thresholds = this->profiles[profile];
+      const auto distance_threshold = thresholds.distance_threshold;
+      const auto cos_threshold = thresholds.cos_threshold;
+      auto profile_left_begin = left_begin;
+      auto right_count = right_distances.size();
+      if (distance_threshold < window_threshold) {
+        profile_left_begin = node_index;
+        while (profile_left_begin > left_begin &&
+               get_distance(profile_left_begin - 1, node_index) <=
+                   distance_threshold) {
+          --profile_left_begin;
+        }
+        right_count = static_cast<std::size_t>(
+            std::find_if(right_distances.begin(), right_distances.end(),
+                         [distance_threshold](double distance) {
+                           return distance > distance_threshold;
+                         }) -
+            right_distances.begin());
+      }
+
+      if (profile_left_begin == node_index || right_count == 0) {
+        continue;
+      }
+
+      const auto max_cosine =
+          distance_model == DistanceModel::haversine
+              ? get_max_cosine_by_sides(node_index, profile_left_begin,
+                                        right_count)
+              : get_max_cosine_by_vectors(profile_left_begin - left_begin,
+                                          right_count);
+      if (max_cosine > cos_threshold) {
+        dangerous_bends.push_back(
+            Bend{.node = nodes[node_index],
+                 .profile = profile,
+                 .min_angle = osmium::geom::rad_to_deg(std::acos(max_cosine)),
+                 .way_id = 0});
+      }
+    }
+  }
+  if (dangerous_bends.size() > bend_count) {
+    ++counters.flagged_way_count;
+  }
+}
+
+void BendDetector::detect(std::span<const osmium::Location> locations,
+                          ProfileMask profiles,
+                          std::vector<Bend> &dangerous_bends) {
+  location_nodes.clear();
+  for (std::size_t index = 0; index < locations.size(); ++index) {
+    location_nodes.emplace_back(static_cast<osmium::object_id_type>(index),
+                                locations[index]);
+  }
+  detect(location_nodes, profiles, dangerous_bends);
+}
+
+auto BendDetector::get_counters() const noexcept -> const Counters & {
+  return counters;
+}
+
+void BendDetector::set_curvature_check(bool enabled) noexcept {
+  curvature_check = enabled;
+}
+
+auto BendDetector::Counters::operator+=(const Counters &other) -> Counters & {
+  way_count += other.way_count;
+  flagged_way_count += other.flagged_way_count;
+  distance_count += other.distance_count;
+  angle_count += other.angle_count;
+  simplified_node_count += other.simplified_node_count;
+  skipped_way_count += other.skipped_way_count;
+  return *this;
+}
+
+void BendDetector::reset(std::span<const osmium::NodeRef> nodes) {
+  this->nodes = nodes;
+  if (distances.size() < nodes.size()) {
+    distances.resize(nodes.size());
+  }
+  for (std::size_t node_index = 0; node_index < nodes.size(); ++node_index) {
+    distances[node_index].clear();
+  }
+
+  if (distance_model == DistanceModel::planar) {
+    projected_nodes.clear();
+    for (const auto &node : nodes) {
+      if (!node.location().valid()) {
+        projected_nodes.push_back(ProjectedNode{.x = 0, .y = 0, .scale = 0});
+        continue;  // Never part of a window, see measure()
+      }
+      const auto latitude = osmium::geom::deg_to_rad(node.location().lat());
+      projected_nodes.push_back(ProjectedNode{
+          .x = osmium::geom::deg_to_rad(node.location().lon()) *
+               osmium::geom::haversine::EARTH_RADIUS_IN_METERS,
+          .y = latitude * osmium::geom::haversine::EARTH_RADIUS_IN_METERS,
+          .scale = std::cos(latitude)});
+    }
+  }
+}
+
+auto BendDetector::get_max_cosine_by_sides(std::size_t node_index,
+                                           std::size_t left_begin,
+                                           std::size_t right_count) -> double {
+  const std::span<const double> dist_a{right_distances.data(), right_count};
+  const auto right_end = node_index + right_count;
+  auto max_cosine = -std::numeric_limits<double>::infinity();
+  for (auto left_node_index = left_begin; left_node_index < node_index;
+       ++left_node_index) {
+    counters.angle_count += right_count;
+    const auto dist_b = get_distance(left_node_index, node_index);
+    const auto dist_c = get_distances(left_node_index, right_end)
+                            .subspan(node_index - left_node_index);
+    max_cosine = std::max(
+        max_cosine, angle_kernel.max_cosine_by_sides(dist_b, dist_a, dist_c));
+  }
+  return max_cosine;
+}
+
+void BendDetector::load_vectors(std::size_t node_index, std::size_t left_begin,
+                                std::size_t right_end) {
+  const auto &center = projected_nodes[node_index];
+  const auto load = [this, &center](std::size_t begin, std::size_t end,
+                                    Vectors &vectors) {
+    vectors.x.clear();
+    vectors.y.clear();
+    vectors.norm.clear();
+    for (auto index = begin; index < end; ++index) {
+      const auto delta_x = (projected_nodes[index].x - center.x) * center.scale;
+      const auto delta_y = projected_nodes[index].y - center.y;
+      vectors.x.push_back(delta_x);
+      vectors.y.push_back(delta_y);
+      vectors.norm.push_back(
+          std::sqrt((delta_x * delta_x) + (delta_y * delta_y)));
+    }
+  };
+  load(left_begin, node_index, left_vectors);
+  load(node_index + 1, right_end + 1, right_vectors);
+}
+
+auto BendDetector::get_max_cosine_by_vectors(std::size_t left_offset,
+                                             std::size_t right_count)
+    -> double {
+  const std::span<const double> right_x{right_vectors.x.data(), right_count};
+  const std::span<const double> right_y{right_vectors.y.data(), right_count};
+  const std::span<const double> right_norm{right_vectors.norm.data(),
+                                           right_count};
+  auto max_cosine = -std::numeric_limits<double>::infinity();
+  for (auto left = left_offset; left < left_vectors.x.size(); ++left) {
+    counters.angle_count += right_count;
+    max_cosine = std::max(
+        max_cosine, angle_kernel.max_cosine_by_vectors(
+                        left_vectors.x[left], left_vectors.y[left],
+                        left_vectors.norm[left], right_x, right_y, right_norm));
+  }
+  return max_cosine;
+}
+
+auto BendDetector::measure(std::size_t from, std::size_t to) const
+    -> double {
+  // Nodes without a location (e.g. outside of the boundary) break windows
+  if (!nodes[from].location().valid() || !nodes[to].location().valid()) {
+    return std::numeric_limits<double>::infinity();
+  }
+  if (distance_model == DistanceModel::haversine) {
+    return osmium::geom::haversine::distance(nodes[from].location(),
+                                             nodes[to].location());
+  }
+
+  const auto &node_a = projected_nodes[from];
+  const auto &node_b = projected_nodes[to];
+  const auto delta_x =
+      (node_b.x - node_a.x) * (node_a.scale + node_b.scale) / 2;
+  const auto delta_y = node_b.y - node_a.y;
+  return std::sqrt((delta_x * delta_x) + (delta_y * delta_y));
+}
+
+auto BendDetector::get_distances(std::size_t from, std::size_t to)
+    -> std::span<const double> {
+  auto &row = distances[from];
+  while (row.size() < to - from) {
+    ++counters.distance_count;
+    row.push_back(measure(from, from + row.size() + 1));
+  }
+  return {row.data(), to - from};
+}
+
+auto BendDetector::get_distance(std::size_t from, std::size_t to) -> double {
+  return get_distances(from, to).back();
+}
+
+auto BendDetector::get_cos_threshold(double angle_threshold) -> double {
+  const auto radian = osmium::geom::deg_to_rad(angle_threshold);
+  if (radian <= 0) {
+    return 1;  // No angle is smaller
+  }
+  if (radian >= osmium::geom::PI) {
+    return -std::numeric_limits<double>::infinity();  // Every angle is smaller
+  }
+  return std::cos(radian);
+}
+
+auto BendDetector::get_max_turn(double angle_threshold) -> double {
+  const auto turn =
+      osmium::geom::PI - osmium::geom::deg_to_rad(angle_threshold);
+  if (turn >= osmium::geom::PI) {
+    return 0;  // Stretches of any length, not worth a proof
+  }
+  return std::max(turn - TURN_MARGIN, 0.0);
+}
+
+auto BendDetector::is_free_of_bends(std::span<const osmium::NodeRef> nodes,
+                                    double max_turn, double turn_span)
+    -> bool {
+  // The headings of the way between two nodes lie within an arc as wide as
+  // the turning between them. Below 180° both the vector to a node before
+  // and the vector to a node after a node lie within the arc of the window,
+  // so the angle between them is at least 180° minus that turning. Nodes
+  // beyond turn_span / 2 along the way are also beyond the distance
+  // threshold, as the way leaves in the direction of the middle of the arc.
+  turns.clear();
+  std::size_t first_turn = 0;
+  double turning = 0;
+  double position = 0;
+  double previous_x = 0;
+  double previous_y = 0;
+  for (std::size_t node_index = 1; node_index < nodes.size(); ++node_index) {
+    const auto &from = nodes[node_index - 1].location();
+    const auto &to = nodes[node_index].location();
+    if (!from.valid() || !to.valid()) {
+      // Windows end at nodes without a location
+      turns.clear();
+      first_turn = 0;
+      turning = 0;
+      previous_x = 0;
+      previous_y = 0;
+      continue;
+    }
+    if (std::abs(to.lat()) > MAX_SKIP_LATITUDE ||
+        std::abs(from.lat()) > MAX_SKIP_LATITUDE) {
+      return false;
+    }
+
+    constexpr double HALF_TURN = 180;
+    auto delta_lon = to.lon() - from.lon();
+    if (std::abs(delta_lon) > HALF_TURN) {
+      delta_lon -= std::copysign(2 * HALF_TURN, delta_lon);
+    }
+    const auto scale =
+        std::cos(osmium::geom::deg_to_rad((from.lat() + to.lat()) / 2));
+    const auto x = osmium::geom::deg_to_rad(delta_lon) * scale *
+                   osmium::geom::haversine::EARTH_RADIUS_IN_METERS;
+    const auto y = osmium::geom::deg_to_rad(to.lat() - from.lat()) *
+                   osmium::geom::haversine::EARTH_RADIUS_IN_METERS;
+    const auto length = std::hypot(x, y);
+    if (length == 0) {
+      return false;  // Nodes at the same place form no angle to bound
+    }
+
+    if (previous_x != 0 || previous_y != 0) {
+      const auto angle =
+          std::atan2(std::abs((previous_x * y) - (previous_y * x)),
+                     (previous_x * x) + (previous_y * y));
+      turns.push_back(Turn{.position = position, .angle = angle});
+      turning += angle;
+      while (position - turns[first_turn].position > turn_span) {
+        turning -= turns[first_turn].angle;
+        ++first_turn;
+      }
+      if (turning >= max_turn) {
+        return false;
+      }
+    }
+    previous_x = x;
+    previous_y = y;
+    position += length;
+  }
+  return true;
+}
@@ -0,0 +1,168 @@
+#include "bend_index_writer.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+using ntask::BendIndexWriter;
+
+namespace {
+
+/// @brief Cells of the Hilbert curve per axis, a power of two
+constexpr std::uint32_t HILBERT_SIZE = std::uint32_t{1} << 16U;
+
+/// @return Position of the cell (@p x, @p y) along the Hilbert curve over
+/// HILBERT_SIZE by HILBERT_SIZE cells
+auto get_hilbert_index(std::uint32_t x, std::uint32_t y) -> std::uint64_t {
+  std::uint64_t index = 0;
+  for (auto half = HILBERT_SIZE / 2; half > 0; half /= 2) {
+    const std::uint32_t right = (x & half) != 0 ? 1 : 0;
+    const std::uint32_t top = (y & half) != 0 ? 1 : 0;
+    index += std::uint64_t{half} * half * ((3 * right) ^ top);
+    // Turn the quadrant so that the curve continues in it
+    if (top == 0) {
+      if (right == 1) {
+        x = HILBERT_SIZE - 1 - x;
+        y = HILBERT_SIZE - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return index;
+}
+
+auto get_box(const ntask::BendRecord &record) -> ntask::BendBox {
+  return {.min_lon = record.lon,
+          .min_lat = record.lat,
+          .max_lon = record.lon,
+          .max_lat = record.lat};
+}
+
+void extend(ntask::BendBox &box, const ntask::BendBox &other) {
+  box.min_lon = std::min(box.min_lon, other.min_lon);
+  box.min_lat = std::min(box.min_lat, other.min_lat);
+  box.max_lon = std::max(box.max_lon, other.max_lon);
+  box.max_lat = std::max(box.max_lat, other.max_lat);
+}
+
+/// @brief Sort @p records along a Hilbert curve over their bounds, so that
+/// bends close to each other end up in the same tree nodes
+void sort_by_hilbert_index(std::vector<ntask::BendRecord> &records) {
+  if (records.empty()) {
+    return;
+  }
+  auto bounds = get_box(records.front());
+  for (const auto &record : records) {
+    extend(bounds, get_box(record));
+  }
+  const auto to_cell = [](std::int32_t coordinate, std::int32_t min,
+                          std::int32_t max) {
+    if (min == max) {
+      return std::uint32_t{0};
+    }
+    return static_cast<std::uint32_t>(
+        static_cast<double>(HILBERT_SIZE - 1) *
+        static_cast<double>(std::int64_t{coordinate} - min) /
+        static_cast<double>(std::int64_t{max} - min));
+  };
+
+  std::vector<std::pair<std::uint64_t, std::uint32_t>> order;
+  order.reserve(records.size());
+  for (std::size_t record = 0; record < records.size(); ++record) {
+    order.emplace_back(
+        get_hilbert_index(
+            to_cell(records[record].lon, bounds.min_lon, bounds.max_lon),
+            to_cell(records[record].lat, bounds.min_lat, bounds.max_lat)),
+        static_cast<std::uint32_t>(record));
+  }
+  std::sort(order.begin(), order.end());
+
+  std::vector<ntask::BendRecord> sorted;
+  sorted.reserve(records.size());
+  for (const auto &[hilbert_index, record] : order) {
+    sorted.push_back(records[record]);
+  }
+  records = std::move(sorted);
+}
+
+/// @return Boxes of all levels of the tree over the sorted @p records, from
+/// the leaves up to the root
+auto pack_boxes(const std::vector<ntask::BendRecord> &records)
+    -> std::vector<ntask::BendBox> {
+  constexpr auto NODE_SIZE = BendIndexWriter::NODE_SIZE;
+  std::vector<ntask::BendBox> boxes;
+  for (std::size_t begin = 0; begin < records.size(); begin += NODE_SIZE) {
+    auto box = get_box(records[begin]);
+    const auto end = std::min<std::size_t>(begin + NODE_SIZE, records.size());
+    for (auto record = begin + 1; record < end; ++record) {
+      extend(box, get_box(records[record]));
+    }
+    boxes.push_back(box);
+  }
+
+  std::size_t level_begin = 0;
+  while (boxes.size() - level_begin > 1) {
+    const auto level_end = boxes.size();
+    for (auto begin = level_begin; begin < level_end; begin += NODE_SIZE) {
+      auto box = boxes[begin];
+      const auto end = std::min<std::size_t>(begin + NODE_SIZE, level_end);
+      for (auto child = begin + 1; child < end; ++child) {
+        extend(box, boxes[child]);
+      }
+      boxes.push_back(box);
+    }
+    level_begin = level_end;
+  }
+  return boxes;
+}
+
+}  // namespace
+
+BendIndexWriter::BendIndexWriter(std::string path, bool deduplicated)
+    : path(std::move(path)), deduplicated(deduplicated) {}
+
+void BendIndexWriter::write(const BendDetector::Bend &bend,
+                            std::uint32_t way_count) {
+  static_assert(osmium::coordinate_precision ==
+                BendTableHeader::COORDINATE_PRECISION);
+  records.push_back(BendRecord{.node_id = bend.node.ref(),
+                               .way_id = bend.way_id,
+                               .lon = bend.node.location().x(),
+                               .lat = bend.node.location().y(),
+                               .min_angle = static_cast<float>(bend.min_angle),
+                               .way_count = way_count});
+}
+
+void BendIndexWriter::close() {
+  if (records.size() > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::runtime_error("Too many bends for an index");
+  }
+  sort_by_hilbert_index(records);
+  const auto boxes = pack_boxes(records);
+
+  const BendIndexHeader header{.magic = BendIndexHeader::MAGIC,
+                               .version = BendIndexHeader::VERSION,
+                               .record_size = sizeof(BendRecord),
+                               .record_count = records.size(),
+                               .box_count = boxes.size(),
+                               .node_size = NODE_SIZE,
+                               .deduplicated = deduplicated ? 1U : 0U};
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error("Can not create " + path);
+  }
+  // NOLINTBEGIN(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char *>(records.data()),
+             static_cast<std::streamsize>(records.size() * sizeof(BendRecord)));
+  file.write(reinterpret_cast<const char *>(boxes.data()),
+             static_cast<std::streamsize>(boxes.size() * sizeof(BendBox)));
+  // NOLINTEND(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.close();
+  if (!file) {
+    throw std::runtime_error("Failed to write the result");
+  }
+  records = {};
+}
@@ -0,0 +1,92 @@
+#include "bend_set.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <stdexcept>
+
+using ntask::BendSet;
+
+namespace {
+
+constexpr std::size_t INITIAL_SLOT_COUNT = 1024;
+
+/// @brief Fibonacci hashing multiplier (2^64 / golden ratio)
+constexpr std::uint64_t HASH_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+}  // namespace
+
+auto BendSet::add(const BendDetector::Bend &bend) -> bool {
+  const auto &node = bend.node;
+  const auto min_angle = static_cast<float>(bend.min_angle);
+  ++added_count;
+  if (bend.way_id != current_way_id) {
+    current_way_id = bend.way_id;
+    current_way_entries.clear();
+  }
+  // Keep the load factor at or below 1/2
+  if ((entries.size() + 1) * 2 > slots.size()) {
+    grow();
+  }
+
+  const auto mask = slots.size() - 1;
+  for (auto slot = get_slot(node.ref());; slot = (slot + 1) & mask) {
+    if (slots[slot] == 0) {
+      if (entries.size() >= std::numeric_limits<std::uint32_t>::max()) {
+        throw std::length_error("Too many dangerous bends");
+      }
+      entries.push_back(Entry{.node = node,
+                              .way_id = bend.way_id,
+                              .min_angle = min_angle,
+                              .way_count = 1});
+      slots[slot] = static_cast<std::uint32_t>(entries.size());
+      current_way_entries.push_back(slots[slot]);
+      return true;
+    }
+    auto &entry = entries[slots[slot] - 1];
+    if (entry.node.ref() == node.ref()) {
+      // A way has few bends, a linear search is enough
+      if (std::find(current_way_entries.begin(), current_way_entries.end(),
+                    slots[slot]) == current_way_entries.end()) {
+        current_way_entries.push_back(slots[slot]);
+        ++entry.way_count;
+      }
+      entry.min_angle = std::min(entry.min_angle, min_angle);
+      return false;
+    }
+  }
+}
+
+auto BendSet::get_entries() const noexcept -> std::span<const Entry> {
+  return entries;
+}
+
+auto BendSet::get_added_count() const noexcept -> std::size_t {
+  return added_count;
+}
+
+auto BendSet::used_memory() const noexcept -> std::size_t {
+  return (entries.capacity() * sizeof(Entry)) +
+         ((slots.capacity() + current_way_entries.capacity()) *
+          sizeof(std::uint32_t));
+}
+
+void BendSet::grow() {
+  slots.assign(slots.empty() ? INITIAL_SLOT_COUNT : slots.size() * 2, 0);
+  const auto mask = slots.size() - 1;
+  for (std::size_t index = 0; index < entries.size(); ++index) {
+    auto slot = get_slot(entries[index].node.ref());
+    while (slots[slot] != 0) {
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = static_cast<std::uint32_t>(index + 1);
+  }
+}
+
+auto BendSet::get_slot(osmium::object_id_type id) const noexcept
+    -> std::size_t {
+  const auto shift = std::numeric_limits<std::uint64_t>::digits -
+                     std::countr_zero(slots.size());
+  return static_cast<std::size_t>(
+      (static_cast<std::uint64_t>(id) * HASH_MULTIPLIER) >> shift);
+}
@@ -0,0 +1,427 @@
+#include "bend_state.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_set>
+
+#include "fnv_hash.hpp"
+
+using ntask::BendChange;
+using ntask::BendState;
+using ntask::BendStateBuilder;
+using ntask::BendStateUpdater;
+
+static_assert(std::is_trivially_copyable_v<ntask::BendDetector::Bend>,
+              "Bends are stored in the state as raw bytes");
+
+namespace {
+
+template <typename T>
+void write_values(std::ofstream &file, std::span<const T> values) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<const char *>(values.data()),
+             static_cast<std::streamsize>(values.size_bytes()));
+}
+
+/// @brief Change of the ways finding a node with one profile by an update
+struct NodeChange {
+  /// @brief Node as found before by the ways scanned again, if any
+  std::optional<osmium::NodeRef> old_node;
+
+  /// @brief Node as found now by the ways scanned again, if any
+  std::optional<osmium::NodeRef> new_node;
+
+  /// @brief Ways finding the node now minus before
+  int count = 0;
+
+  /// @return Whether the ways scanned again find the node at another location
+  [[nodiscard]] auto moved() const -> bool {
+    return old_node && new_node &&
+           old_node->location() != new_node->location();
+  }
+};
+
+template <typename T>
+auto read_values(std::ifstream &file, std::size_t count) -> std::vector<T> {
+  std::vector<T> values(count);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.read(reinterpret_cast<char *>(values.data()),
+            static_cast<std::streamsize>(count * sizeof(T)));
+  return values;
+}
+
+}  // namespace
+
+auto BendState::Key::make(
+    const std::vector<FilterRules> &filter_rules,
+    const std::vector<BendDetector::Thresholds> &thresholds,
+    BendDetector::DistanceModel distance_model, std::uint64_t boundary_hash,
+    double simplify_tolerance) -> Key {
+  std::uint64_t detector_hash =
+      fnv_hash_value(FNV_OFFSET_BASIS, distance_model);
+  for (const auto &profile : thresholds) {
+    detector_hash = fnv_hash_value(detector_hash, profile.distance_threshold);
+    detector_hash = fnv_hash_value(detector_hash, profile.angle_threshold);
+  }
+  // Keeps the keys of states computed without simplification
+  if (simplify_tolerance > 0) {
+    detector_hash = fnv_hash_value(detector_hash, simplify_tolerance);
+  }
+  return Key{.filter_hash = fnv_hash_value(
+                 WayCacheKey::hash_filters(filter_rules), boundary_hash),
+             .detector_hash = detector_hash};
+}
+
+BendState::BendState(const Key &key) : key(key) {}
+
+auto BendState::load(const std::string &path, const Key &key)
+    -> std::optional<BendState> {
+  std::ifstream file{path, std::ios::binary};
+  Header header{};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  if (!file.read(reinterpret_cast<char *>(&header), sizeof header) ||
+      header.magic != MAGIC || header.version != VERSION) {
+    return std::nullopt;
+  }
+  if (!(header.key == key)) {
+    throw std::runtime_error(path +
+                             " was computed with other filters or thresholds");
+  }
+
+  const auto way_ids =
+      read_values<osmium::object_id_type>(file, header.way_count);
+  const auto profiles = read_values<ProfileMask>(file, header.way_count);
+  const auto node_offsets =
+      read_values<std::uint64_t>(file, header.way_count + 1);
+  const auto bend_offsets =
+      read_values<std::uint64_t>(file, header.way_count + 1);
+  const auto nodes = read_values<osmium::NodeRef>(file, header.node_count);
+  const auto bends =
+      read_values<BendDetector::Bend>(file, header.bend_count);
+  const auto stale_way_ids =
+      read_values<osmium::object_id_type>(file, header.stale_way_count);
+  if (!file) {
+    throw std::runtime_error("Truncated state file " + path);
+  }
+
+  BendState state{key};
+  for (std::size_t way = 0; way < way_ids.size(); ++way) {
+    const auto node_begin =
+        nodes.begin() + static_cast<std::ptrdiff_t>(node_offsets[way]);
+    const auto node_end =
+        nodes.begin() + static_cast<std::ptrdiff_t>(node_offsets[way + 1]);
+    const auto bend_begin =
+        bends.begin() + static_cast<std::ptrdiff_t>(bend_offsets[way]);
+    const auto bend_end =
+        bends.begin() + static_cast<std::ptrdiff_t>(bend_offsets[way + 1]);
+    state.ways.emplace_hint(state.ways.end(), way_ids[way],
+                            WayState{.profiles = profiles[way],
+                                     .nodes = {node_begin, node_end},
+                                     .bends = {bend_begin, bend_end}});
+  }
+  state.stale_ways.insert(stale_way_ids.cbegin(), stale_way_ids.cend());
+  return state;
+}
+
+void BendState::save(const std::string &path) const {
+  Header header{.magic = MAGIC,
+                .version = VERSION,
+                .key = key,
+                .way_count = ways.size(),
+                .node_count = 0,
+                .bend_count = 0,
+                .stale_way_count = stale_ways.size()};
+  std::vector<osmium::object_id_type> way_ids;
+  std::vector<ProfileMask> profiles;
+  std::vector<std::uint64_t> node_offsets{0};
+  std::vector<std::uint64_t> bend_offsets{0};
+  for (const auto &[way_id, way_state] : ways) {
+    way_ids.push_back(way_id);
+    profiles.push_back(way_state.profiles);
+    header.node_count += way_state.nodes.size();
+    header.bend_count += way_state.bends.size();
+    node_offsets.push_back(header.node_count);
+    bend_offsets.push_back(header.bend_count);
+  }
+
+  const auto temporary_path = path + ".tmp";
+  std::ofstream file{temporary_path, std::ios::binary | std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error("Can not create " + temporary_path);
+  }
+  write_values(file, std::span<const Header>{&header, 1});
+  write_values(file, std::span<const osmium::object_id_type>{way_ids});
+  write_values(file, std::span<const ProfileMask>{profiles});
+  write_values(file, std::span<const std::uint64_t>{node_offsets});
+  write_values(file, std::span<const std::uint64_t>{bend_offsets});
+  for (const auto &[way_id, way_state] : ways) {
+    write_values(file, std::span<const osmium::NodeRef>{way_state.nodes});
+  }
+  for (const auto &[way_id, way_state] : ways) {
+    write_values(file, std::span<const BendDetector::Bend>{way_state.bends});
+  }
+  const std::vector<osmium::object_id_type> stale_way_ids{stale_ways.cbegin(),
+                                                          stale_ways.cend()};
+  write_values(file, std::span<const osmium::object_id_type>{stale_way_ids});
+  file.close();
+  if (!file) {
+    throw std::runtime_error("Failed to write " + temporary_path);
+  }
+
+  std::filesystem::rename(temporary_path, path);
+}
+
+auto BendState::get_ways() const noexcept
+    -> const std::map<osmium::object_id_type, WayState> & {
+  return ways;
+}
+
+void BendState::set_way(osmium::object_id_type way_id,
+                        std::optional<WayState> way_state) {
+  if (way_state) {
+    ways.insert_or_assign(way_id, std::move(*way_state));
+  } else {
+    ways.erase(way_id);
+  }
+}
+
+auto BendState::get_stale_ways() const noexcept
+    -> const std::set<osmium::object_id_type> & {
+  return stale_ways;
+}
+
+void BendState::set_stale(osmium::object_id_type way_id, bool stale) {
+  if (stale) {
+    stale_ways.insert(way_id);
+  } else {
+    stale_ways.erase(way_id);
+  }
+}
+
+BendStateBuilder::BendStateBuilder(BendState &state,
+                                   const WayFilter &way_filter,
+                                   BendDetector &detector)
+    : state(state), way_filter(way_filter), detector(detector) {}
+
+void BendStateBuilder::way(const osmium::Way &way) {
+  const auto profiles = way_filter.match(way);
+  if (profiles == 0) {
+    return;
+  }
+
+  BendState::WayState way_state{
+      .profiles = profiles,
+      .nodes = {way.nodes().cbegin(), way.nodes().cend()},
+      .bends = {}};
+  detector.detect(way_state.nodes, profiles, way_state.bends);
+  for (auto &bend : way_state.bends) {
+    bend.way_id = way.id();
+  }
+  state.set_way(way.id(), std::move(way_state));
+}
+
+BendStateUpdater::BendStateUpdater(BendState &state,
+                                   const WayFilter &way_filter,
+                                   BendDetector &detector,
+                                   const Boundary *boundary)
+    : state(state),
+      way_filter(way_filter),
+      detector(detector),
+      boundary(boundary) {}
+
+void BendStateUpdater::node(const osmium::Node &node) {
+  // A change file may hold several versions of an object, the last one wins
+  const auto location = node.location();
+  changed_nodes.insert_or_assign(
+      node.id(),
+      node.visible() && (boundary == nullptr || boundary->contains(location))
+          ? location
+          : osmium::Location{});
+}
+
+void BendStateUpdater::way(const osmium::Way &way) {
+  const auto profiles = way.visible() ? way_filter.match(way) : 0;
+  if (profiles == 0) {
+    changed_ways.insert_or_assign(way.id(), std::nullopt);
+    return;
+  }
+
+  ChangedWay changed_way{.profiles = profiles, .node_ids = {}};
+  for (const auto &node : way.nodes()) {
+    changed_way.node_ids.push_back(node.ref());
+  }
+  changed_ways.insert_or_assign(way.id(), std::move(changed_way));
+}
+
+auto BendStateUpdater::apply() -> std::vector<BendChange> {
+  std::unordered_map<osmium::object_id_type, osmium::Location> locations;
+  std::vector<osmium::object_id_type> moved_ways;
+  resolve(locations, moved_ways);
+
+  std::map<std::pair<std::size_t, osmium::object_id_type>, NodeChange>
+      node_changes;
+  const auto replace = [this, &node_changes](
+                           osmium::object_id_type way_id,
+                           std::optional<BendState::WayState> way_state) {
+    // Like in a full run, a way without any node inside of the boundary is
+    // left out
+    if (way_state && std::none_of(way_state->nodes.cbegin(),
+                                  way_state->nodes.cend(),
+                                  [](const osmium::NodeRef &node) {
+                                    return node.location().valid();
+                                  })) {
+      way_state.reset();
+    }
+    const auto &ways = state.get_ways();
+    if (const auto old_way = ways.find(way_id); old_way != ways.end()) {
+      for (const auto &bend : old_way->second.bends) {
+        auto &node_change = node_changes[{bend.profile, bend.node.ref()}];
+        node_change.old_node = bend.node;
+        --node_change.count;
+      }
+    }
+    if (way_state) {
+      detector.detect(way_state->nodes, way_state->profiles, way_state->bends);
+      for (auto &bend : way_state->bends) {
+        bend.way_id = way_id;
+      }
+      ++updated_way_count;
+      for (const auto &bend : way_state->bends) {
+        auto &node_change = node_changes[{bend.profile, bend.node.ref()}];
+        node_change.new_node = bend.node;
+        ++node_change.count;
+      }
+    }
+    state.set_way(way_id, std::move(way_state));
+  };
+  // Without a location for each node a way can not be scanned, nodes known
+  // to have no valid location (deleted or outside of the boundary) only break
+  // the windows of the detector
+  const auto rescan = [this, &locations, &replace](
+                          osmium::object_id_type way_id, ProfileMask profiles,
+                          std::span<const osmium::object_id_type> node_ids) {
+    BendState::WayState way_state{
+        .profiles = profiles, .nodes = {}, .bends = {}};
+    for (const auto node_id : node_ids) {
+      const auto location = locations.find(node_id);
+      if (location == locations.end()) {
+        // Its bends would be guessed either way, the previous ones are kept
+        // until a full run
+        ++unresolved_way_count;
+        state.set_stale(way_id, true);
+        return;
+      }
+      way_state.nodes.emplace_back(node_id, location->second);
+    }
+    replace(way_id, std::move(way_state));
+    state.set_stale(way_id, false);
+  };
+
+  // An unchanged way keeps its stored nodes, only the moved ones get their
+  // new location
+  for (const auto way_id : moved_ways) {
+    if (changed_ways.contains(way_id)) {
+      continue;  // The new version of the way is applied below
+    }
+    const auto &stored_way = state.get_ways().at(way_id);
+    BendState::WayState way_state{
+        .profiles = stored_way.profiles, .nodes = stored_way.nodes,
+        .bends = {}};
+    for (auto &node : way_state.nodes) {
+      if (const auto changed = changed_nodes.find(node.ref());
+          changed != changed_nodes.end()) {
+        node.set_location(changed->second);
+      }
+    }
+    replace(way_id, std::move(way_state));
+  }
+  for (const auto &[way_id, changed_way] : changed_ways) {
+    if (changed_way) {
+      rescan(way_id, changed_way->profiles, changed_way->node_ids);
+    } else {
+      replace(way_id, std::nullopt);
+      state.set_stale(way_id, false);
+    }
+  }
+
+  // Whether a node is found before and after depends on all ways finding it
+  std::erase_if(node_changes, [](const auto &node_change) {
+    return node_change.second.count == 0 && !node_change.second.moved();
+  });
+  std::map<std::pair<std::size_t, osmium::object_id_type>, int> counts;
+  for (const auto &[way_id, way_state] : state.get_ways()) {
+    for (const auto &bend : way_state.bends) {
+      const std::pair key{bend.profile, bend.node.ref()};
+      if (node_changes.contains(key)) {
+        ++counts[key];
+      }
+    }
+  }
+
+  // A node still found at another location is removed at the old one and
+  // added at the new one, consumers of the changes know it moved
+  std::vector<BendChange> bend_changes;
+  for (const auto &[key, node_change] : node_changes) {
+    const auto count = counts[key];
+    const auto old_count = count - node_change.count;
+    if (old_count > 0 && (count == 0 || node_change.moved())) {
+      bend_changes.push_back(BendChange{.node = *node_change.old_node,
+                                        .profile = key.first,
+                                        .added = false});
+    }
+    if (count > 0 && (old_count == 0 || node_change.moved())) {
+      bend_changes.push_back(BendChange{.node = *node_change.new_node,
+                                        .profile = key.first,
+                                        .added = true});
+    }
+  }
+  changed_nodes.clear();
+  changed_ways.clear();
+  return bend_changes;
+}
+
+auto BendStateUpdater::get_updated_way_count() const noexcept -> std::size_t {
+  return updated_way_count;
+}
+
+auto BendStateUpdater::get_unresolved_way_count() const noexcept
+    -> std::size_t {
+  return unresolved_way_count;
+}
+
+void BendStateUpdater::resolve(
+    std::unordered_map<osmium::object_id_type, osmium::Location> &locations,
+    std::vector<osmium::object_id_type> &moved_ways) const {
+  locations = changed_nodes;
+  std::unordered_set<osmium::object_id_type> needed_nodes;
+  for (const auto &[way_id, changed_way] : changed_ways) {
+    if (changed_way) {
+      for (const auto node_id : changed_way->node_ids) {
+        if (!locations.contains(node_id)) {
+          needed_nodes.insert(node_id);
+        }
+      }
+    }
+  }
+
+  // One pass over the state finds the ways with moved nodes and the
+  // locations of unchanged nodes of changed ways
+  for (const auto &[way_id, way_state] : state.get_ways()) {
+    bool moved = false;
+    for (const auto &node : way_state.nodes) {
+      if (const auto changed = changed_nodes.find(node.ref());
+          changed != changed_nodes.end()) {
+        moved = moved || changed->second != node.location();
+      } else if (needed_nodes.contains(node.ref())) {
+        locations.emplace(node.ref(), node.location());
+      }
+    }
+    if (moved) {
+      moved_ways.push_back(way_id);
+    }
+  }
+}
@@ -0,0 +1,56 @@
+#include "bend_table_writer.hpp"
+
+#include <stdexcept>
+
+using ntask::BendTableWriter;
+
+namespace {
+
+constexpr std::size_t BUFFER_SIZE = std::size_t{1} << 20U;
+
+}  // namespace
+
+BendTableWriter::BendTableWriter(const std::string &path, bool deduplicated)
+    : buffer(BUFFER_SIZE),
+      header{.magic = BendTableHeader::MAGIC,
+             .version = BendTableHeader::VERSION,
+             .record_size = sizeof(BendRecord),
+             .record_count = 0,
+             .deduplicated = deduplicated ? 1U : 0U,
+             .reserved = 0} {
+  file.rdbuf()->pubsetbuf(buffer.data(),
+                          static_cast<std::streamsize>(buffer.size()));
+  file.open(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Can not create " + path);
+  }
+  // Written again with the number of records by close()
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void BendTableWriter::write(const BendDetector::Bend &bend,
+                            std::uint32_t way_count) {
+  // osmium stores locations with the same fixed-point precision
+  static_assert(osmium::coordinate_precision ==
+                BendTableHeader::COORDINATE_PRECISION);
+  const BendRecord record{.node_id = bend.node.ref(),
+                          .way_id = bend.way_id,
+                          .lon = bend.node.location().x(),
+                          .lat = bend.node.location().y(),
+                          .min_angle = static_cast<float>(bend.min_angle),
+                          .way_count = way_count};
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<const char *>(&record), sizeof(record));
+  ++header.record_count;
+}
+
+void BendTableWriter::close() {
+  file.seekp(0);
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  file.close();
+  if (!file) {
+    throw std::runtime_error("Failed to write the result");
+  }
+}
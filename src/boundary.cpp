@@ -0,0 +1,284 @@
+#include "boundary.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+
+#include "fnv_hash.hpp"
+#include "nlohmann/json.hpp"
+
+using ntask::Boundary;
+
+namespace {
+
+/// @brief Upper bound of the rows and columns of the grid, which has about
+/// one cell per edge
+constexpr std::size_t MAX_GRID_SIZE = 1024;
+
+/// @brief Edges per strip aimed at, a point in a crossed cell is tested
+/// against the edges of its strip
+constexpr std::size_t STRIP_EDGE_COUNT = 8;
+
+constexpr std::size_t MAX_STRIP_COUNT = std::size_t{1} << 16U;
+
+/// @brief Bound of the strips an edge is stored in on average, edges spanning
+/// many strips limit the number of strips
+constexpr double MAX_STRIPS_PER_EDGE = 4;
+
+constexpr std::size_t MIN_RING_SIZE = 3;
+
+auto read_poly(std::ifstream &file) -> std::vector<Boundary::Ring> {
+  std::vector<Boundary::Ring> rings;
+  std::string line;
+  std::getline(file, line);  // Name of the polygon
+  while (std::getline(file, line) && line.rfind("END", 0) != 0) {
+    // Section of a ring, named `!...` for holes which the even-odd rule
+    // takes care of
+    Boundary::Ring ring;
+    while (std::getline(file, line)) {
+      std::istringstream coordinates{line};
+      double lon = 0;
+      double lat = 0;
+      if (!(coordinates >> lon >> lat)) {
+        break;  // END of the section
+      }
+      ring.emplace_back(lon, lat);
+    }
+    rings.push_back(std::move(ring));
+  }
+  return rings;
+}
+
+void read_geojson(const nlohmann::json &object,
+                  std::vector<Boundary::Ring> &rings) {
+  const auto add_polygon = [&rings](const nlohmann::json &polygon) {
+    for (const auto &coordinates : polygon) {
+      Boundary::Ring ring;
+      for (const auto &position : coordinates) {
+        ring.emplace_back(position.at(0).get<double>(),
+                          position.at(1).get<double>());
+      }
+      rings.push_back(std::move(ring));
+    }
+  };
+
+  const auto type = object.value("type", std::string{});
+  if (type == "FeatureCollection") {
+    for (const auto &feature : object.at("features")) {
+      read_geojson(feature, rings);
+    }
+  } else if (type == "Feature") {
+    read_geojson(object.at("geometry"), rings);
+  } else if (type == "GeometryCollection") {
+    for (const auto &geometry : object.at("geometries")) {
+      read_geojson(geometry, rings);
+    }
+  } else if (type == "Polygon") {
+    add_polygon(object.at("coordinates"));
+  } else if (type == "MultiPolygon") {
+    for (const auto &polygon : object.at("coordinates")) {
+      add_polygon(polygon);
+    }
+  }
+}
+
+}  // namespace
+
+Boundary::Boundary(const std::vector<Ring> &rings) : hash(FNV_OFFSET_BASIS) {
+  std::vector<Edge> edges;
+  double total_height = 0;
+  double min_x = std::numeric_limits<double>::infinity();
+  double min_y = min_x;
+  double max_x = -min_x;
+  double max_y = -min_x;
+  for (const auto &ring : rings) {
+    if (ring.size() < MIN_RING_SIZE) {
+      continue;
+    }
+    hash = fnv_hash_value(hash, ring.size());
+    for (std::size_t vertex = 0; vertex < ring.size(); ++vertex) {
+      const auto &from = ring[vertex];
+      const auto &to = ring[(vertex + 1) % ring.size()];
+      hash = fnv_hash_value(hash, from);
+      edges.push_back(Edge{.x1 = static_cast<double>(from.x()),
+                           .y1 = static_cast<double>(from.y()),
+                           .x2 = static_cast<double>(to.x()),
+                           .y2 = static_cast<double>(to.y())});
+      total_height += std::abs(edges.back().y2 - edges.back().y1);
+      min_x = std::min(min_x, edges.back().x1);
+      min_y = std::min(min_y, edges.back().y1);
+      max_x = std::max(max_x, edges.back().x1);
+      max_y = std::max(max_y, edges.back().y1);
+    }
+  }
+  if (edges.empty()) {
+    throw std::runtime_error("Boundary without a polygon");
+  }
+
+  bottom_left = osmium::Location{static_cast<std::int32_t>(min_x),
+                                 static_cast<std::int32_t>(min_y)};
+  top_right = osmium::Location{static_cast<std::int32_t>(max_x),
+                               static_cast<std::int32_t>(max_y)};
+  grid_size = std::clamp(
+      static_cast<std::size_t>(std::sqrt(static_cast<double>(edges.size()))),
+      std::size_t{1}, MAX_GRID_SIZE);
+  cell_width = std::max(max_x - min_x, 1.0) / static_cast<double>(grid_size);
+  cell_height = std::max(max_y - min_y, 1.0) / static_cast<double>(grid_size);
+  const auto height = std::max(max_y - min_y, 1.0);
+  const auto edge_count = static_cast<double>(edges.size());
+  strip_count = std::clamp(
+      static_cast<std::size_t>(std::min(
+          edge_count / STRIP_EDGE_COUNT,
+          (MAX_STRIPS_PER_EDGE - 1) * edge_count * height /
+              std::max(total_height, 1.0))),
+      std::size_t{1}, MAX_STRIP_COUNT);
+  strip_height = height / static_cast<double>(strip_count);
+  const auto get_column = [this, min_x](double x) {
+    return std::min(static_cast<std::size_t>(std::max(x - min_x, 0.0) /
+                                             cell_width),
+                    grid_size - 1);
+  };
+  const auto get_row = [this, min_y](double y) {
+    return std::min(static_cast<std::size_t>(std::max(y - min_y, 0.0) /
+                                             cell_height),
+                    grid_size - 1);
+  };
+
+  // Edges go to every strip they overlap, cells they cross are marked with a
+  // margin of one cell against rounding
+  strip_edges.resize(strip_count);
+  cells.assign(grid_size * grid_size, Cell::outside);
+  for (const auto &edge : edges) {
+    for (auto strip = get_strip(std::min(edge.y1, edge.y2));
+         strip <= get_strip(std::max(edge.y1, edge.y2)); ++strip) {
+      strip_edges[strip].push_back(edge);
+    }
+
+    const auto first_row = get_row(std::min(edge.y1, edge.y2));
+    const auto last_row = get_row(std::max(edge.y1, edge.y2));
+    for (auto row = first_row; row <= last_row; ++row) {
+      // Part of the edge within the row
+      const auto row_y1 =
+          std::max(min_y + (static_cast<double>(row) * cell_height),
+                   std::min(edge.y1, edge.y2));
+      const auto row_y2 =
+          std::min(min_y + (static_cast<double>(row + 1) * cell_height),
+                   std::max(edge.y1, edge.y2));
+      const auto x_at = [&edge](double y) {
+        return edge.y1 == edge.y2 ? edge.x1
+                                  : edge.x1 + ((edge.x2 - edge.x1) *
+                                               (y - edge.y1) /
+                                               (edge.y2 - edge.y1));
+      };
+      auto first_column =
+          get_column(edge.y1 == edge.y2 ? std::min(edge.x1, edge.x2)
+                                        : std::min(x_at(row_y1), x_at(row_y2)));
+      auto last_column =
+          get_column(edge.y1 == edge.y2 ? std::max(edge.x1, edge.x2)
+                                        : std::max(x_at(row_y1), x_at(row_y2)));
+      first_column = first_column > 0 ? first_column - 1 : 0;
+      last_column = std::min(last_column + 1, grid_size - 1);
+      for (auto marked_row = row > 0 ? row - 1 : 0;
+           marked_row <= std::min(row + 1, grid_size - 1); ++marked_row) {
+        for (auto column = first_column; column <= last_column; ++column) {
+          cells[(marked_row * grid_size) + column] = Cell::crossed;
+        }
+      }
+    }
+  }
+
+  // A cell no edge crosses is inside or outside as a whole, like its center
+  for (std::size_t row = 0; row < grid_size; ++row) {
+    const auto center_y =
+        min_y + ((static_cast<double>(row) + 0.5) * cell_height);
+    for (std::size_t column = 0; column < grid_size; ++column) {
+      auto &cell = cells[(row * grid_size) + column];
+      if (cell != Cell::crossed) {
+        const auto center_x =
+            min_x + ((static_cast<double>(column) + 0.5) * cell_width);
+        cell = crosses_odd(center_x, center_y) ? Cell::inside
+                                               : Cell::outside;
+      }
+    }
+  }
+}
+
+auto Boundary::from_box(const osmium::Location &bottom_left,
+                        const osmium::Location &top_right) -> Boundary {
+  Boundary boundary{{{bottom_left,
+                      osmium::Location{top_right.x(), bottom_left.y()},
+                      top_right,
+                      osmium::Location{bottom_left.x(), top_right.y()}}}};
+  // The test of the rings leaves out the top and right edges, a box includes
+  // them like osmium::Box::contains
+  boundary.is_box = true;
+  boundary.hash = fnv_hash_value(boundary.hash, boundary.is_box);
+  return boundary;
+}
+
+auto Boundary::from_file(const std::string &path) -> Boundary {
+  std::ifstream file{path};
+  if (!file) {
+    throw std::runtime_error("Can not open " + path);
+  }
+
+  constexpr std::string_view POLY_SUFFIX = ".poly";
+  std::vector<Ring> rings;
+  if (path.ends_with(POLY_SUFFIX)) {
+    rings = read_poly(file);
+  } else {
+    read_geojson(nlohmann::json::parse(file), rings);
+  }
+  return Boundary{rings};
+}
+
+auto Boundary::contains(const osmium::Location &location) const -> bool {
+  if (!location.valid() || location.x() < bottom_left.x() ||
+      location.x() > top_right.x() || location.y() < bottom_left.y() ||
+      location.y() > top_right.y()) {
+    return false;
+  }
+  if (is_box) {
+    return true;
+  }
+
+  const auto x = static_cast<double>(location.x());
+  const auto y = static_cast<double>(location.y());
+  const auto column = std::min(
+      static_cast<std::size_t>((x - bottom_left.x()) / cell_width),
+      grid_size - 1);
+  const auto row = std::min(
+      static_cast<std::size_t>((y - bottom_left.y()) / cell_height),
+      grid_size - 1);
+  const auto cell = cells[(row * grid_size) + column];
+  if (cell != Cell::crossed) {
+    return cell == Cell::inside;
+  }
+  return crosses_odd(x, y);
+}
+
+auto Boundary::get_hash() const noexcept -> std::uint64_t { return hash; }
+
+auto Boundary::get_strip(double y) const -> std::size_t {
+  return std::min(
+      static_cast<std::size_t>(std::max(y - bottom_left.y(), 0.0) /
+                               strip_height),
+      strip_count - 1);
+}
+
+auto Boundary::crosses_odd(double x, double y) const -> bool {
+  // Crossings of a ray from the point to the right (PNPOLY)
+  bool inside = false;
+  for (const auto &edge : strip_edges[get_strip(y)]) {
+    if ((edge.y1 > y) != (edge.y2 > y) &&
+        x < edge.x1 + ((edge.x2 - edge.x1) * (y - edge.y1) /
+                       (edge.y2 - edge.y1))) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
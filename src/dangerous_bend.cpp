@@ -1,99 +1,184 @@
 #include "dangerous_bend.hpp"
 
-#include <osmium/geom/haversine.hpp>
-
+using ntask::BendDetector;
 using ntask::DangerousBendHandler;
+using ntask::FilterRules;
+using ntask::WayStitcher;
+
+namespace {
+
+/// @brief Nodes per batch handed to a worker, large enough to make the
+/// hand-over cost negligible against scanning
+constexpr std::size_t BATCH_NODE_COUNT = 1U << 16U;
+
+constexpr std::size_t BATCH_BUFFER_SIZE = 1U << 20U;
+
+}  // namespace
+
+auto DangerousBendHandler::Configuration::get_filter_rules() const
+    -> std::vector<FilterRules> {
+  std::vector<FilterRules> filter_rules;
+  for (const auto &profile : profiles) {
+    filter_rules.push_back(
+        FilterRules{.highway_tags = profile.highway_tags,
+                    .blacklisted_tags = profile.blacklisted_tags});
+  }
+  return filter_rules;
+}
+
+auto DangerousBendHandler::Configuration::get_thresholds() const
+    -> std::vector<BendDetector::Thresholds> {
+  std::vector<BendDetector::Thresholds> thresholds;
+  for (const auto &profile : profiles) {
+    thresholds.push_back(BendDetector::Thresholds{
+        .distance_threshold = profile.distance_threshold,
+        .angle_threshold = profile.angle_threshold});
+  }
+  return thresholds;
+}
 
 DangerousBendHandler::DangerousBendHandler(const Configuration &configuration)
+    : DangerousBendHandler(configuration, {}) {}
+
+DangerousBendHandler::DangerousBendHandler(const Configuration &configuration,
+                                           BendSink sink)
     : configuration(configuration),
-      angle_threshold(osmium::geom::deg_to_rad(configuration.angle_threshold)) {
+      way_filter(configuration.get_filter_rules()),
+      detector(configuration.get_thresholds(), configuration.distance_model,
+               configuration.simplify_tolerance),
+      sink(std::move(sink)) {
+  if (configuration.threads > 1) {
+    pool = std::make_unique<WayBatchPool>(detector, configuration.threads);
+  }
+  if (configuration.stitch_endpoints > 0) {
+    stitcher = std::make_unique<WayStitcher>(configuration.get_thresholds(),
+                                             configuration.distance_model,
+                                             configuration.stitch_endpoints);
+  }
 }
 
 void DangerousBendHandler::way(const osmium::Way &way) {
-  if (std::any_of(
-          configuration.blacklisted_tags.begin(),
-          configuration.blacklisted_tags.end(),
-          [&way](const std::pair<std::string, std::string> &blacklisted_tag) {
-            return way.tags().has_tag(blacklisted_tag.first.c_str(),
-                                      blacklisted_tag.second.c_str());
-          })) {
+  const auto profiles = way_filter.match(way);
+  if (profiles == 0) {
     return;
   }
+  if (stitcher) {
+    stitcher->add(way.id(), {way.nodes().cbegin(), way.nodes().cend()},
+                  profiles, WayStitcher::get_key(way.tags()), junction_bends);
+  }
 
-  const auto *highway_value = way.tags().get_value_by_key("highway");
-  if (highway_value == nullptr) {
+  if (!pool) {
+    add_dangerous_bend(way.id(), {way.nodes().cbegin(), way.nodes().cend()},
+                       profiles);
     return;
   }
-  if (std::all_of(configuration.highway_tags.cbegin(),
-                  configuration.highway_tags.cend(),
-                  [highway_value](const std::string &highway_tag) {
-                    return highway_tag != highway_value;
-                  })) {
+
+  // Node spans into the buffer are only taken in submit_batch(), the buffer
+  // may move while growing.
+  if (!batch.buffer) {
+    submit_batch();  // Keeps spans added before in order
+    batch.buffer = osmium::memory::Buffer{
+        BATCH_BUFFER_SIZE, osmium::memory::Buffer::auto_grow::yes};
+  }
+  batch.buffer.add_item(way);
+  batch.buffer.commit();
+  batch.profiles.push_back(profiles);
+  batch.way_ids.push_back(way.id());
+  batch_node_count += way.nodes().size();
+  if (batch_node_count >= BATCH_NODE_COUNT) {
+    submit_batch();
+  }
+}
+
+void DangerousBendHandler::add_dangerous_bend(
+    osmium::object_id_type way_id, std::span<const osmium::NodeRef> nodes,
+    ProfileMask profiles) {
+  if (!pool) {
+    way_bends.clear();
+    detector.detect(nodes, profiles, way_bends);
+    for (auto &bend : way_bends) {
+      bend.way_id = way_id;
+    }
+    emit(way_bends);
     return;
   }
 
-  add_dangerous_bend(way);
+  if (batch.buffer) {
+    submit_batch();  // Keeps ways added before in order
+  }
+  batch.ways.push_back(nodes);
+  batch.profiles.push_back(profiles);
+  batch.way_ids.push_back(way_id);
+  batch_node_count += nodes.size();
+  if (batch_node_count >= BATCH_NODE_COUNT) {
+    submit_batch();
+  }
+}
+
+void DangerousBendHandler::finish() {
+  if (pool) {
+    submit_batch();
+    for (const auto &batch_bends : pool->finish()) {
+      emit(batch_bends);
+    }
+    pool_counters += pool->get_counters();
+    pool.reset();
+  }
+
+  // After the bends of all ways, so that the order does not depend on the
+  // number of threads
+  emit(junction_bends);
+  junction_bends.clear();
 }
 
 auto DangerousBendHandler::get_dangerous_bends() const noexcept
-    -> const std::vector<osmium::NodeRef> & {
+    -> const std::vector<BendDetector::Bend> & {
   return dangerous_bends;
 }
 
-void DangerousBendHandler::add_dangerous_bend(const osmium::Way &way) {
-  const auto &nodes = way.nodes();
-
-  for (int node_index = 0; node_index < static_cast<int>(nodes.size());
-       ++node_index) {
-    std::vector<int> left_node_indices;
-    std::vector<int> right_node_indices;
-
-    for (int left_node_index = node_index - 1; left_node_index >= 0;
-         --left_node_index) {
-      if (osmium::geom::haversine::distance(nodes[left_node_index].location(),
-                                            nodes[node_index].location()) >
-          configuration.distance_threshold) {
-        break;
-      }
-
-      left_node_indices.push_back(left_node_index);
-    }
-
-    for (int right_node_index = node_index + 1;
-         right_node_index < static_cast<int>(nodes.size());
-         ++right_node_index) {
-      if (osmium::geom::haversine::distance(nodes[right_node_index].location(),
-                                            nodes[node_index].location()) >
-          configuration.distance_threshold) {
-        break;
-      }
+auto DangerousBendHandler::get_detector_counters() const
+    -> BendDetector::Counters {
+  auto counters = detector.get_counters();
+  counters += pool_counters;
+  if (stitcher) {
+    // Junctions are counted by the stitcher, not as ways
+    auto junction_counters = stitcher->get_detector_counters();
+    junction_counters.way_count = 0;
+    junction_counters.flagged_way_count = 0;
+    counters += junction_counters;
+  }
+  return counters;
+}
 
-      right_node_indices.push_back(right_node_index);
-    }
+auto DangerousBendHandler::get_stitcher() const noexcept
+    -> const WayStitcher * {
+  return stitcher.get();
+}
 
-    double min_angle = std::numeric_limits<double>::infinity();
-    for (auto left_index : left_node_indices) {
-      for (auto right_index : right_node_indices) {
-        min_angle =
-            std::min(min_angle, get_angle(nodes[left_index].location(),
-                                          nodes[node_index].location(),
-                                          nodes[right_index].location()));
-      }
+void DangerousBendHandler::submit_batch() {
+  if (batch.buffer) {
+    for (const auto &way : batch.buffer.select<osmium::Way>()) {
+      batch.ways.emplace_back(way.nodes().cbegin(), way.nodes().cend());
     }
+  }
+  if (!batch.ways.empty()) {
+    pool->submit(std::move(batch));
+  }
+  batch = WayBatch{};
+  batch_node_count = 0;
 
-    if (min_angle < angle_threshold) {
-      dangerous_bends.push_back(nodes[node_index]);
-    }
+  for (const auto &batch_bends : pool->take_completed()) {
+    emit(batch_bends);
   }
 }
 
-auto DangerousBendHandler::get_angle(const osmium::Location &node_a,
-                                     const osmium::Location &node_c,
-                                     const osmium::Location &node_b) -> double {
-  const double dist_a = osmium::geom::haversine::distance(node_c, node_b);
-  const double dist_b = osmium::geom::haversine::distance(node_a, node_c);
-  const double dist_c = osmium::geom::haversine::distance(node_a, node_b);
-
-  return std::acos(((dist_a * dist_a) + (dist_b * dist_b) - (dist_c * dist_c)) /
-                   (2 * dist_a * dist_b));
+void DangerousBendHandler::emit(
+    const std::vector<BendDetector::Bend> &bends) {
+  if (sink) {
+    for (const auto &bend : bends) {
+      sink(bend);
+    }
+  } else {
+    dangerous_bends.insert(dangerous_bends.end(), bends.begin(), bends.end());
+  }
 }
@@ -0,0 +1,68 @@
+#include "json_writer.hpp"
+
+#include <stdexcept>
+
+#include "nlohmann/json.hpp"
+
+using ntask::JsonWriter;
+
+namespace {
+
+constexpr std::size_t BUFFER_SIZE = std::size_t{1} << 20U;
+constexpr int PRETTY_INDENT = 2;
+constexpr int COMPACT_INDENT = -1;
+
+}  // namespace
+
+JsonWriter::JsonWriter(const std::string &path, bool compact)
+    : buffer(BUFFER_SIZE),
+      indent(compact ? COMPACT_INDENT : PRETTY_INDENT),
+      separator(compact ? "," : ",\n") {
+  file.rdbuf()->pubsetbuf(buffer.data(),
+                          static_cast<std::streamsize>(buffer.size()));
+  file.open(path, std::ios::trunc);
+  if (!file) {
+    throw std::runtime_error("Can not create " + path);
+  }
+  file << '[';
+}
+
+void JsonWriter::write(const osmium::NodeRef &node,
+                       std::optional<std::uint32_t> way_count) {
+  nlohmann::json record{
+      {"location", {{"lat", node.lat()}, {"lon", node.lon()}}},
+      {"link",
+       "https://www.openstreetmap.org/node/" + std::to_string(node.ref())}};
+  if (way_count) {
+    record["way_count"] = *way_count;
+  }
+
+  file << (empty ? (indent < 0 ? "" : "\n") : separator);
+  empty = false;
+  if (indent < 0) {
+    file << record.dump();
+    return;
+  }
+
+  // Nest the pretty printed record one level into the array
+  const auto text = record.dump(indent);
+  const std::string padding(static_cast<std::size_t>(indent), ' ');
+  file << padding;
+  for (const auto character : text) {
+    file << character;
+    if (character == '\n') {
+      file << padding;
+    }
+  }
+}
+
+void JsonWriter::close() {
+  if (!empty && indent >= 0) {
+    file << '\n';
+  }
+  file << ']' << std::endl;
+  file.close();
+  if (!file) {
+    throw std::runtime_error("Failed to write the result");
+  }
+}
@@ -0,0 +1,76 @@
+#include "location_index.hpp"
+
+#include <unistd.h>
+
+#include <osmium/index/map/all.hpp>
+#include <stdexcept>
+
+namespace {
+
+/// @brief Rough upper bound of node IDs in OSM, a dense index needs one slot
+/// per ID up to here
+constexpr std::uintmax_t MAX_NODE_ID = 13'000'000'000;
+
+/// @brief Average input bytes per node (including the ways and relations
+/// coming with it) measured on regional extracts
+constexpr std::uintmax_t PBF_BYTES_PER_NODE = 8;
+constexpr std::uintmax_t COMPRESSED_XML_BYTES_PER_NODE = 12;
+constexpr std::uintmax_t XML_BYTES_PER_NODE = 100;
+
+/// @brief Within this factor of the dense index size the estimate is too
+/// rough to pick a layout, flex_mem starts sparse and turns dense on its own
+constexpr std::uintmax_t FLEX_RANGE = 8;
+
+constexpr std::uintmax_t DENSE_BYTES_PER_ID = sizeof(osmium::Location);
+constexpr std::uintmax_t SPARSE_BYTES_PER_NODE =
+    sizeof(osmium::unsigned_object_id_type) + sizeof(osmium::Location);
+
+auto estimate_node_count(const osmium::io::File &file,
+                         std::uintmax_t file_size) -> std::uintmax_t {
+  if (file.format() == osmium::io::file_format::pbf) {
+    return file_size / PBF_BYTES_PER_NODE;
+  }
+  if (file.compression() != osmium::io::file_compression::none) {
+    return file_size / COMPRESSED_XML_BYTES_PER_NODE;
+  }
+  return file_size / XML_BYTES_PER_NODE;
+}
+
+}  // namespace
+
+auto ntask::create_location_index(const std::string &name)
+    -> std::unique_ptr<LocationIndex> {
+  const auto &map_factory =
+      osmium::index::MapFactory<osmium::unsigned_object_id_type,
+                                osmium::Location>::instance();
+  const auto type = name.substr(0, name.find(','));
+  if (!map_factory.has_map_type(type)) {
+    throw std::runtime_error("Unknown location index: " + name);
+  }
+  return map_factory.create_map(name);
+}
+
+auto ntask::suggest_location_index(const osmium::io::File &file,
+                                   std::uintmax_t file_size,
+                                   std::uintmax_t memory_budget,
+                                   const std::string &index_file)
+    -> std::string {
+  const auto node_count = estimate_node_count(file, file_size);
+  const auto sparse_size = node_count * SPARSE_BYTES_PER_NODE;
+  const auto dense_size = MAX_NODE_ID * DENSE_BYTES_PER_ID;
+
+  if (sparse_size >= dense_size) {
+    return dense_size <= memory_budget ? "dense_mmap_array"
+                                       : "dense_file_array," + index_file;
+  }
+  if (sparse_size * FLEX_RANGE >= dense_size && dense_size <= memory_budget) {
+    return "flex_mem";
+  }
+  return sparse_size <= memory_budget ? "sparse_mem_array"
+                                      : "sparse_file_array," + index_file;
+}
+
+auto ntask::get_physical_memory() -> std::uintmax_t {
+  return static_cast<std::uintmax_t>(sysconf(_SC_PHYS_PAGES)) *
+         static_cast<std::uintmax_t>(sysconf(_SC_PAGE_SIZE));
+}
@@ -1,60 +1,651 @@
+#include <deque>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <osmium/handler/node_locations_for_ways.hpp>
-#include <osmium/index/map/sparse_mem_array.hpp>
 #include <osmium/io/gzip_compression.hpp>
+#include <osmium/io/pbf_input.hpp>
 #include <osmium/io/xml_input.hpp>
+#include <osmium/thread/pool.hpp>
 #include <osmium/visitor.hpp>
+#include <variant>
 
+#include "bend_index_writer.hpp"
+#include "bend_set.hpp"
+#include "bend_state.hpp"
+#include "bend_table_writer.hpp"
+#include "boundary.hpp"
 #include "dangerous_bend.hpp"
+#include "json_writer.hpp"
+#include "location_index.hpp"
 #include "nlohmann/json.hpp"
+#include "pipeline.hpp"
+#include "route_file.hpp"
+#include "run_report.hpp"
+#include "way_cache.hpp"
+#include "way_nodes.hpp"
+
+namespace {
+
+using LocationHandler =
+    osmium::handler::NodeLocationsForWays<ntask::LocationIndex>;
+
+/// @brief How the input file is read
+struct ReadOptions {
+  /// @brief Whether versions, timestamps, changesets and users of the objects
+  /// are decoded, nothing here needs them
+  osmium::io::read_meta read_meta;
+
+  /// @brief Read the file twice to only store the locations of nodes used by
+  /// accepted ways
+  bool two_pass;
+
+  /// @brief Only locations of nodes inside are stored and only ways with a
+  /// node inside are passed on, if set
+  std::optional<ntask::Boundary> boundary;
+
+  /// @brief Read, locate and detect on their own threads and add the time
+  /// spent by each stage here, if set
+  ntask::PipelineStats* pipeline_stats;
+
+  /// @brief Add the time spent by the location handler here when not
+  /// pipelined
+  ntask::StageTime* locate_time;
+
+  /// @brief Add the time spent by the handler after it here when not
+  /// pipelined
+  ntask::StageTime* detect_time;
+};
+
+/// @brief Apply @p reader to @p location_handler and then @p handler, as a
+/// pipeline if enabled in @p options
+template <typename TLocationHandler, typename THandler>
+void apply_stages(osmium::io::Reader& reader, const ReadOptions& options,
+                  TLocationHandler& location_handler, THandler& handler) {
+  if (options.pipeline_stats != nullptr) {
+    ntask::run_pipeline(reader, location_handler, handler,
+                        *options.pipeline_stats);
+    return;
+  }
+
+  // Buffer by buffer like the pipeline, to time both handlers apart
+  while (auto buffer = reader.read()) {
+    {
+      const ntask::ScopedStageTimer timer{*options.locate_time};
+      osmium::apply(buffer, location_handler);
+    }
+    const ntask::ScopedStageTimer timer{*options.detect_time};
+    osmium::apply(buffer, handler);
+  }
+}
+
+/// @brief Apply @p reader to @p location_handler and then @p handler, within
+/// the boundary of @p options if set
+/// @return Objects read
+template <typename TLocationHandler, typename THandler>
+auto apply_located(osmium::io::Reader& reader, const ReadOptions& options,
+                   TLocationHandler& location_handler, THandler& handler)
+    -> ntask::ObjectCounts {
+  ntask::ObjectCounts counts;
+  if (options.boundary) {
+    ntask::BoundedNodeLocations bounded_location_handler{*options.boundary,
+                                                         location_handler};
+    ntask::ObjectCounter counting_handler{bounded_location_handler, counts};
+    ntask::LocatedWays located_handler{handler};
+    apply_stages(reader, options, counting_handler, located_handler);
+  } else {
+    ntask::ObjectCounter counting_handler{location_handler, counts};
+    apply_stages(reader, options, counting_handler, handler);
+  }
+  return counts;
+}
+
+/// @brief Read @p input_file, resolve the node locations of its ways and pass
+/// the ways to @p handler
+/// @return Objects read, by the second pass in the two-pass mode
+template <typename THandler>
+auto read_ways(const osmium::io::File& input_file, osmium::thread::Pool& pool,
+               const ReadOptions& options, const ntask::WayFilter& way_filter,
+               LocationHandler& location_handler, THandler& handler)
+    -> ntask::ObjectCounts {
+  if (options.boundary) {
+    location_handler.ignore_errors();  // Ways leaving the boundary
+  }
+  if (!options.two_pass) {
+    osmium::io::Reader reader{
+        input_file,
+        osmium::osm_entity_bits::node | osmium::osm_entity_bits::way, pool,
+        options.read_meta};
+    const auto counts =
+        apply_located(reader, options, location_handler, handler);
+    reader.close();
+    return counts;
+  }
+
+  // First pass only reads ways to find out which node locations the filtered
+  // ways need, the second pass stores just those.
+  ntask::WayNodeCollector way_node_collector{way_filter};
+  osmium::io::Reader way_reader{input_file, osmium::osm_entity_bits::way, pool,
+                                options.read_meta};
+  osmium::apply(way_reader, way_node_collector);
+  way_reader.close();
+
+  location_handler.ignore_errors();
+  ntask::FilteredNodeLocations filtered_location_handler{
+      location_handler, way_node_collector.get_node_ids()};
+  osmium::io::Reader reader{
+      input_file, osmium::osm_entity_bits::node | osmium::osm_entity_bits::way,
+      pool, options.read_meta};
+  const auto counts =
+      apply_located(reader, options, filtered_location_handler, handler);
+  reader.close();
+  return counts;
+}
+
+/// @return Boundary of `boundary` (`[min_lon, min_lat, max_lon, max_lat]`)
+/// or `boundary_file` in @p config, if any
+auto parse_boundary(const nlohmann::json& config)
+    -> std::optional<ntask::Boundary> {
+  if (config.contains("boundary")) {
+    const auto& box = config["boundary"];
+    return ntask::Boundary::from_box(
+        osmium::Location{box.at(0).get<double>(), box.at(1).get<double>()},
+        osmium::Location{box.at(2).get<double>(), box.at(3).get<double>()});
+  }
+  if (config.contains("boundary_file")) {
+    return ntask::Boundary::from_file(config["boundary_file"]);
+  }
+  return std::nullopt;
+}
+
+/// @return Distance model by its name in the configuration
+auto parse_distance_model(const std::string& name)
+    -> ntask::BendDetector::DistanceModel {
+  if (name == "haversine") {
+    return ntask::BendDetector::DistanceModel::haversine;
+  }
+  if (name == "planar") {
+    return ntask::BendDetector::DistanceModel::planar;
+  }
+  throw std::runtime_error("Unknown distance model: " + name);
+}
+
+/// @brief Parse a blacklisted tag of the config, `{"key", "value"}` matches a
+/// value, `{"key", "value_regex"}` a regular expression and a lone `{"key"}`
+/// any value
+auto parse_tag_rule(const nlohmann::json& tag) -> ntask::TagRule {
+  if (tag.contains("value")) {
+    return {.key = tag["key"],
+            .value = tag["value"],
+            .match = ntask::TagRule::Match::value};
+  }
+  if (tag.contains("value_regex")) {
+    return {.key = tag["key"],
+            .value = tag["value_regex"],
+            .match = ntask::TagRule::Match::value_regex};
+  }
+  return {.key = tag["key"],
+          .value = {},
+          .match = ntask::TagRule::Match::any_value};
+}
+
+/// @return Configuration of each profile: the entries of `profiles` on top of
+/// the top level keys, or the top level keys alone without `profiles`
+auto get_profile_configs(const nlohmann::json& config)
+    -> std::vector<nlohmann::json> {
+  if (!config.contains("profiles")) {
+    return {config};
+  }
+
+  auto defaults = config;
+  defaults.erase("profiles");
+  std::vector<nlohmann::json> profile_configs;
+  for (const auto& profile : config["profiles"]) {
+    auto profile_config = defaults;
+    profile_config.update(profile);
+    profile_configs.push_back(std::move(profile_config));
+  }
+  return profile_configs;
+}
+
+/// @return Filters and thresholds of a profile
+auto parse_profile(const nlohmann::json& profile_config)
+    -> ntask::DangerousBendHandler::Profile {
+  std::vector<ntask::TagRule> blacklisted_tags;
+  std::transform(profile_config["blacklisted_tags"].cbegin(),
+                 profile_config["blacklisted_tags"].cend(),
+                 std::back_inserter(blacklisted_tags), parse_tag_rule);
+  return {.highway_tags = profile_config["highway_tags"],
+          .blacklisted_tags = blacklisted_tags,
+          .distance_threshold = profile_config["distance_threshold"],
+          .angle_threshold = profile_config["angle_threshold"]};
+}
+
+/// @brief Write the nodes found or not found anymore after applying a change
+/// file to `<output_file>.added.json` and `<output_file>.removed.json` of
+/// each profile
+void write_bend_changes(const std::vector<ntask::BendChange>& bend_changes,
+                        const std::vector<nlohmann::json>& profile_configs) {
+  std::deque<ntask::JsonWriter> added_writers;
+  std::deque<ntask::JsonWriter> removed_writers;
+  for (const auto& profile_config : profile_configs) {
+    const auto output_file =
+        static_cast<std::string>(profile_config["output_file"]);
+    const auto compact = profile_config.value("compact_output", false);
+    added_writers.emplace_back(output_file + ".added.json", compact);
+    removed_writers.emplace_back(output_file + ".removed.json", compact);
+  }
+
+  for (const auto& bend_change : bend_changes) {
+    (bend_change.added ? added_writers : removed_writers)[bend_change.profile]
+        .write(bend_change.node);
+  }
+  for (std::size_t profile = 0; profile < profile_configs.size(); ++profile) {
+    added_writers[profile].close();
+    removed_writers[profile].close();
+  }
+}
+
+/// @brief Writes the result of a profile in its `output_format`: `json`
+/// (default), `binary`, a bend table (see @c ntask::BendTable), or `index`, a
+/// bend index (see @c ntask::BendIndex)
+class ResultWriter {
+ public:
+  ResultWriter(const nlohmann::json& profile_config, bool deduplicated) {
+    const auto output_file =
+        static_cast<std::string>(profile_config["output_file"]);
+    const auto output_format =
+        profile_config.value("output_format", std::string{"json"});
+    if (output_format == "json") {
+      writer.emplace<ntask::JsonWriter>(
+          output_file, profile_config.value("compact_output", false));
+    } else if (output_format == "binary") {
+      writer.emplace<ntask::BendTableWriter>(output_file, deduplicated);
+    } else if (output_format == "index") {
+      writer.emplace<ntask::BendIndexWriter>(output_file, deduplicated);
+    } else {
+      throw std::runtime_error("Unknown output_format " + output_format);
+    }
+  }
+
+  /// @param way_count Number of ways the node was found in, if deduplicated
+  void write(const ntask::BendDetector::Bend& bend,
+             std::optional<std::uint32_t> way_count = std::nullopt) {
+    if (auto* json_writer = std::get_if<ntask::JsonWriter>(&writer)) {
+      json_writer->write(bend.node, way_count);
+    } else if (auto* table_writer =
+                   std::get_if<ntask::BendTableWriter>(&writer)) {
+      table_writer->write(bend, way_count.value_or(1));
+    } else {
+      std::get<ntask::BendIndexWriter>(writer).write(bend,
+                                                     way_count.value_or(1));
+    }
+  }
+
+  void close() {
+    if (auto* json_writer = std::get_if<ntask::JsonWriter>(&writer)) {
+      json_writer->close();
+    } else if (auto* table_writer =
+                   std::get_if<ntask::BendTableWriter>(&writer)) {
+      table_writer->close();
+    } else {
+      std::get<ntask::BendIndexWriter>(writer).close();
+    }
+  }
+
+ private:
+  std::variant<std::monostate, ntask::JsonWriter, ntask::BendTableWriter,
+               ntask::BendIndexWriter>
+      writer;
+};
+
+/// @brief Print @p report and write it to `report_file` if set in @p config
+void print_report(const ntask::RunReport& report,
+                  const nlohmann::json& config) {
+  report.print(std::cout);
+  const auto report_file = config.value("report_file", std::string{});
+  if (!report_file.empty()) {
+    report.write_json(report_file);
+  }
+}
+
+/// @brief Find the bends along every route of `route_file` in the bend index
+/// `bend_index_file` and write them to `output_file`, the `routes` mode
+void query_routes(const nlohmann::json& routes_config,
+                  ntask::RunReport& report) {
+  constexpr double DEFAULT_WIDTH = 25;
+  const auto default_width = routes_config.value("width", DEFAULT_WIDTH);
+  const auto bend_index_file =
+      static_cast<std::string>(routes_config["bend_index_file"]);
+  const auto route_file = static_cast<std::string>(routes_config["route_file"]);
+  const auto output_file =
+      static_cast<std::string>(routes_config["output_file"]);
+
+  report.start_stage("load");
+  const ntask::BendIndex index{bend_index_file};
+  const auto routes = ntask::read_routes(route_file);
+
+  report.start_stage("query");
+  std::ofstream file{output_file, std::ios::trunc};
+  if (!file) {
+    throw std::runtime_error("Can not create " + output_file);
+  }
+  file << '[';
+  std::uint64_t bend_count = 0;
+  for (std::size_t route = 0; route < routes.size(); ++route) {
+    nlohmann::json bends = nlohmann::json::array();
+    for (const auto& [record, distance, position] : index.query_corridor(
+             routes[route].points,
+             routes[route].width.value_or(default_width))) {
+      bends.push_back(
+          {{"location",
+            {{"lat", record->get_lat()}, {"lon", record->get_lon()}}},
+           {"link", "https://www.openstreetmap.org/node/" +
+                        std::to_string(record->node_id)},
+           {"way_id", record->way_id},
+           {"min_angle", record->min_angle},
+           {"distance", distance},
+           {"position", position}});
+    }
+    bend_count += bends.size();
+    // One route per line
+    file << (route == 0 ? "\n" : ",\n")
+         << nlohmann::json{{"name", routes[route].name},
+                           {"bends", std::move(bends)}}
+                .dump();
+  }
+  file << (routes.empty() ? "]" : "\n]") << std::endl;
+  file.close();
+  if (!file) {
+    throw std::runtime_error("Failed to write the result");
+  }
+  report.stop_stage();
+
+  report.add_info("bend_index_file", bend_index_file);
+  report.add_count("bends_indexed", index.records().size());
+  report.add_count("routes", routes.size(), "query");
+  report.add_count("route_bends", bend_count);
+  report.finish(std::filesystem::file_size(route_file));
+}
+
+}  // namespace
 
 auto main() -> int {
   try {
+    ntask::RunReport report;
+    report.start_stage("setup");
     constexpr const char* CONFIG_FILE_NAME = "config.json";
     std::ifstream config_file(CONFIG_FILE_NAME);
     const auto config = nlohmann::json::parse(config_file);
+    if (config.contains("routes")) {
+      query_routes(config["routes"], report);
+      print_report(report, config);
+      return 0;
+    }
 
-    osmium::io::Reader reader{
+    // The format is derived from the file name suffix (`.osm.pbf`, `.osm.gz`,
+    // ...) unless `input_format` overrides it.
+    const osmium::io::File input_file{
         static_cast<std::string>(config["input_file"]),
-        osmium::osm_entity_bits::node | osmium::osm_entity_bits::way};
-
-    using IndexType =
-        osmium::index::map::SparseMemArray<osmium::unsigned_object_id_type,
-                                           osmium::Location>;
-    IndexType index;
-    auto location_handler =
-        osmium::handler::NodeLocationsForWays<IndexType>{index};
-
-    std::vector<std::pair<std::string, std::string>> blacklisted_tags;
-    std::transform(
-        config["blacklisted_tags"].cbegin(), config["blacklisted_tags"].cend(),
-        std::back_inserter(blacklisted_tags), [](const auto& blacklisted_tag) {
-          return std::make_pair(blacklisted_tag["key"],
-                                blacklisted_tag["value"]);
-        });
-
-    ntask::DangerousBendHandler dangerous_bend_handler{
-        ntask::DangerousBendHandler::Configuration{
-            .highway_tags = config["highway_tags"],
-            .blacklisted_tags = blacklisted_tags,
-            .distance_threshold = config["distance_threshold"],
-            .angle_threshold = config["angle_threshold"]}};
-
-    osmium::apply(reader, location_handler, dangerous_bend_handler);
-    reader.close();
+        config.value("input_format", std::string{})};
 
-    auto result = nlohmann::json::array();
-    for (const auto& node : dangerous_bend_handler.get_dangerous_bends()) {
-      result.push_back(nlohmann::json{
-          {"location", {{"lat", node.lat()}, {"lon", node.lon()}}},
-          {"link", "https://www.openstreetmap.org/node/" +
-                       std::to_string(node.ref())}});
+    // PBF blocks are decoded in parallel on this pool; 0 lets osmium pick the
+    // number of threads from the hardware.
+    osmium::thread::Pool pool{config.value("reader_threads", 0)};
+
+    // Bends only need tags of ways and locations of nodes, `lean_read` skips
+    // decoding and storing the metadata (version, timestamp, changeset, user)
+    // of every object.
+    const auto read_meta = config.value("lean_read", false)
+                               ? osmium::io::read_meta::no
+                               : osmium::io::read_meta::yes;
+    // `pipeline` overlaps reading, locating and detecting instead of
+    // alternating between them on one thread.
+    std::optional<ntask::PipelineStats> pipeline_stats;
+    if (config.value("pipeline", false)) {
+      pipeline_stats.emplace();
+    }
+    ntask::StageTime locate_time;
+    ntask::StageTime detect_time;
+    const ReadOptions read_options{
+        .read_meta = read_meta,
+        .two_pass = config.value("two_pass", false),
+        .boundary = parse_boundary(config),
+        .pipeline_stats = pipeline_stats ? &*pipeline_stats : nullptr,
+        .locate_time = &locate_time,
+        .detect_time = &detect_time};
+    const auto boundary_hash =
+        read_options.boundary ? read_options.boundary->get_hash() : 0;
+
+    auto location_index_name =
+        config.value("location_index", std::string{"sparse_mem_array"});
+    // Applying a change file takes the locations from the state, the input
+    // file may not exist anymore
+    const auto change_mode =
+        !config.value("state_file", std::string{}).empty() &&
+        !config.value("change_file", std::string{}).empty();
+    if (location_index_name == "auto" && change_mode) {
+      location_index_name = "sparse_mem_array";
+    } else if (location_index_name == "auto") {
+      location_index_name = ntask::suggest_location_index(
+          input_file, std::filesystem::file_size(input_file.filename()),
+          ntask::get_physical_memory() / 2,
+          config.value("location_index_file", std::string{"locations.idx"}));
     }
+    const auto index = ntask::create_location_index(location_index_name);
+    LocationHandler location_handler{*index};
+
+    // Every profile has its own filters, thresholds and output file; all of
+    // them are evaluated in the same pass over the input.
+    const auto profile_configs = get_profile_configs(config);
+    std::vector<ntask::DangerousBendHandler::Profile> profiles;
+    std::vector<std::string> profile_names;
+    // Duplicates are only known at the end, deduplicated results are kept
+    // in a compact set until then instead of being written right away.
+    const auto deduplicate = config.value("deduplicate", false);
+    std::deque<ResultWriter> result_writers;
+    for (const auto& profile_config : profile_configs) {
+      profiles.push_back(parse_profile(profile_config));
+      profile_names.push_back(profile_config.value(
+          "name", "profile " + std::to_string(profile_names.size())));
+      result_writers.emplace_back(profile_config, deduplicate);
+    }
+
+    // Ends of ways waiting for their continuing way, about 150 bytes each
+    constexpr std::size_t DEFAULT_STITCH_ENDPOINTS = std::size_t{1} << 20U;
+    const ntask::DangerousBendHandler::Configuration configuration{
+        .profiles = profiles,
+        .distance_model = parse_distance_model(
+            config.value("distance_model", std::string{"haversine"})),
+        .threads = config.value("threads", std::size_t{1}),
+        .stitch_endpoints =
+            config.value("stitch_ways", false)
+                ? config.value("stitch_endpoints", DEFAULT_STITCH_ENDPOINTS)
+                : 0,
+        .simplify_tolerance = config.value("simplify_tolerance", 0.0)};
+    std::vector<ntask::BendSet> bend_sets(profiles.size());
+    std::vector<std::uint64_t> bend_counts(profiles.size());
+    const auto add_bend = [deduplicate, &bend_sets, &bend_counts,
+                           &result_writers](
+                              const ntask::BendDetector::Bend& bend) {
+      ++bend_counts[bend.profile];
+      if (deduplicate) {
+        bend_sets[bend.profile].add(bend);
+      } else {
+        result_writers[bend.profile].write(bend);
+      }
+    };
+    ntask::DangerousBendHandler dangerous_bend_handler{configuration,
+                                                       add_bend};
 
-    std::ofstream result_file{config["output_file"]};
-    result_file << result.dump(2) << std::endl;
+    const ntask::WayFilter way_filter{configuration.get_filter_rules()};
 
+    // With a state file the result of every way is kept, so that a later run
+    // with `change_file` only scans the ways touched by the changes.
+    const auto state_file = config.value("state_file", std::string{});
+    const auto change_file = config.value("change_file", std::string{});
+    const auto way_cache_file = config.value("way_cache_file", std::string{});
+    if (configuration.stitch_endpoints > 0 &&
+        (!state_file.empty() || !way_cache_file.empty())) {
+      throw std::runtime_error(
+          "stitch_ways needs the tags of the ways, it can not be used with "
+          "state_file or way_cache_file");
+    }
+    report.start_stage("read");
+    ntask::ObjectCounts object_counts;
+    ntask::BendDetector::Counters detector_counters;
+    std::uint64_t updated_way_count = 0;
+    std::uint64_t unresolved_way_count = 0;
+    std::uint64_t stale_way_count = 0;
+    if (!state_file.empty()) {
+      const auto state_key = ntask::BendState::Key::make(
+          configuration.get_filter_rules(), configuration.get_thresholds(),
+          configuration.distance_model, boundary_hash,
+          configuration.simplify_tolerance);
+      ntask::BendDetector detector{configuration.get_thresholds(),
+                                   configuration.distance_model,
+                                   configuration.simplify_tolerance};
+      std::optional<ntask::BendState> state;
+      if (change_file.empty()) {
+        state.emplace(state_key);
+        ntask::BendStateBuilder state_builder{*state, way_filter, detector};
+        object_counts = read_ways(input_file, pool, read_options, way_filter,
+                                  location_handler, state_builder);
+      } else {
+        state = ntask::BendState::load(state_file, state_key);
+        if (!state) {
+          throw std::runtime_error("No state in " + state_file +
+                                   ", run once without change_file");
+        }
+        ntask::BendStateUpdater state_updater{
+            *state, way_filter, detector,
+            read_options.boundary ? &*read_options.boundary : nullptr};
+        osmium::io::Reader reader{
+            osmium::io::File{change_file},
+            osmium::osm_entity_bits::node | osmium::osm_entity_bits::way,
+            pool, read_meta};
+        ntask::ObjectCounter counting_updater{state_updater, object_counts};
+        osmium::apply(reader, counting_updater);
+        reader.close();
+        write_bend_changes(state_updater.apply(), profile_configs);
+        updated_way_count = state_updater.get_updated_way_count();
+        unresolved_way_count = state_updater.get_unresolved_way_count();
+        stale_way_count = state->get_stale_ways().size();
+      }
+
+      detector_counters = detector.get_counters();
+
+      for (const auto& [way_id, way_state] : state->get_ways()) {
+        for (const auto& bend : way_state.bends) {
+          add_bend(bend);
+        }
+      }
+      state->save(state_file);
+    } else if (way_cache_file.empty()) {
+      object_counts = read_ways(input_file, pool, read_options, way_filter,
+                                location_handler, dangerous_bend_handler);
+      {
+        // Waits for the batches still scanned by the workers
+        const ntask::ScopedStageTimer timer{detect_time};
+        dangerous_bend_handler.finish();
+      }
+      detector_counters = dangerous_bend_handler.get_detector_counters();
+    } else {
+      // The cache holds the filtered ways with their node locations, a valid
+      // one spares reading the input file at all.
+      const auto way_cache_key =
+          ntask::WayCacheKey::make(input_file.filename(),
+                                   configuration.get_filter_rules(),
+                                   boundary_hash);
+      auto way_cache = ntask::WayCache::load(way_cache_file, way_cache_key);
+      if (!way_cache) {
+        ntask::WayCacheWriter way_cache_writer{way_cache_file, way_cache_key,
+                                               way_filter};
+        object_counts = read_ways(input_file, pool, read_options, way_filter,
+                                  location_handler, way_cache_writer);
+        way_cache_writer.close();
+        way_cache = ntask::WayCache::load(way_cache_file, way_cache_key);
+        if (!way_cache) {
+          throw std::runtime_error("Can not load " + way_cache_file);
+        }
+      }
+
+      const ntask::ScopedStageTimer timer{detect_time};
+      for (std::size_t way_index = 0; way_index < way_cache->size();
+           ++way_index) {
+        dangerous_bend_handler.add_dangerous_bend(
+            way_cache->way_id(way_index), way_cache->nodes(way_index),
+            way_cache->profiles(way_index));
+      }
+      dangerous_bend_handler.finish();
+      detector_counters = dangerous_bend_handler.get_detector_counters();
+    }
+
+    report.start_stage("write");
+    for (std::size_t profile = 0; profile < profiles.size(); ++profile) {
+      for (const auto& entry : bend_sets[profile].get_entries()) {
+        result_writers[profile].write(
+            ntask::BendDetector::Bend{.node = entry.node,
+                                      .profile = profile,
+                                      .min_angle = entry.min_angle,
+                                      .way_id = entry.way_id},
+            entry.way_count);
+      }
+      result_writers[profile].close();
+    }
+
+    report.stop_stage();
+    if (!pipeline_stats && !change_mode) {
+      report.add_stage("locate", locate_time, "read");
+      report.add_stage("detect", detect_time, "read");
+    }
+
+    report.add_info("location_index", location_index_name);
+    report.add_info("angle_kernel",
+                    std::string{ntask::AngleKernel::get().name});
+    report.add_count("nodes_read", object_counts.node_count, "read");
+    report.add_count("ways_read", object_counts.way_count, "read");
+    report.add_count("ways_scanned", detector_counters.way_count, "read");
+    report.add_count("ways_flagged", detector_counters.flagged_way_count);
+    report.add_count("ways_skipped_by_curvature",
+                     detector_counters.skipped_way_count);
+    report.add_count("distances_measured", detector_counters.distance_count,
+                     "read");
+    report.add_count("angles_evaluated", detector_counters.angle_count,
+                     "read");
+    if (configuration.simplify_tolerance > 0) {
+      report.add_count("nodes_simplified_away",
+                       detector_counters.simplified_node_count);
+    }
+    if (change_mode) {
+      report.add_count("ways_updated", updated_way_count);
+      report.add_count("ways_unresolved", unresolved_way_count);
+      report.add_count("ways_stale", stale_way_count);
+    }
+    for (std::size_t profile = 0; profile < profiles.size(); ++profile) {
+      const auto& name = profile_names[profile];
+      report.add_count("bends (" + name + ")", bend_counts[profile]);
+      if (deduplicate) {
+        report.add_count("distinct_bends (" + name + ")",
+                         bend_sets[profile].get_entries().size());
+        report.add_memory("bend_set (" + name + ")",
+                          bend_sets[profile].used_memory());
+      }
+    }
+    if (const auto* stitcher = dangerous_bend_handler.get_stitcher()) {
+      const auto& stitch_counters = stitcher->get_counters();
+      report.add_count("way_ends_waiting", stitch_counters.endpoint_count);
+      report.add_count("junctions_stitched", stitch_counters.junction_count);
+      report.add_count("way_ends_dropped", stitch_counters.dropped_count);
+      report.add_memory("way_stitcher", stitcher->used_memory());
+    }
+    report.add_memory("location_index", index->used_memory());
+    if (pipeline_stats) {
+      report.add_pipeline(*pipeline_stats);
+    }
+    report.finish(std::filesystem::file_size(
+        change_file.empty() ? input_file.filename() : change_file));
+    print_report(report, config);
     return 0;
   } catch (const std::exception& err) {
     std::cerr << "Exception occurred: " << err.what() << std::endl;
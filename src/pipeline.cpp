@@ -0,0 +1,28 @@
+#include "pipeline.hpp"
+
+using ntask::PipelineStats;
+using ntask::StageTimer;
+
+auto PipelineStats::Stage::get_utilization() const noexcept -> double {
+  const auto total = busy + waiting;
+  if (total.count() == 0) {
+    return 0;
+  }
+  return static_cast<double>(busy.count()) /
+         static_cast<double>(total.count());
+}
+
+StageTimer::StageTimer(PipelineStats::Stage &stage)
+    : stage(stage), last(std::chrono::steady_clock::now()) {}
+
+void StageTimer::add_busy() { stage.busy += lap(); }
+
+void StageTimer::add_waiting() { stage.waiting += lap(); }
+
+auto StageTimer::lap() -> std::chrono::nanoseconds {
+  const auto now = std::chrono::steady_clock::now();
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(now - last);
+  last = now;
+  return elapsed;
+}
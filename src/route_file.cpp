@@ -0,0 +1,212 @@
+#include "route_file.hpp"
+
+#include <expat.h>
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+
+#include "nlohmann/json.hpp"
+
+using ntask::Route;
+
+namespace {
+
+constexpr std::size_t GPX_BUFFER_SIZE = std::size_t{1} << 16U;
+
+/// @brief Collects the routes of a GPX file from the callbacks of expat
+class GpxReader {
+ public:
+  GpxReader(XML_Parser parser, std::vector<Route> &routes)
+      : parser(parser), routes(routes) {}
+
+  /// @return Error which stopped the parser, empty if none
+  [[nodiscard]] auto get_error() const -> const std::string & { return error; }
+
+  static void start_element(void *data, const char *name,
+                            const char **attributes) {
+    static_cast<GpxReader *>(data)->start(name, attributes);
+  }
+
+  static void end_element(void *data, const char *name) {
+    static_cast<GpxReader *>(data)->end(name);
+  }
+
+  static void character_data(void *data, const char *text, int length) {
+    auto &reader = *static_cast<GpxReader *>(data);
+    if (reader.in_name) {
+      reader.name.append(text, static_cast<std::size_t>(length));
+    }
+  }
+
+ private:
+  void start(std::string_view element, const char **attributes) {
+    if (element == "trk" || element == "rte") {
+      first_route = routes.size();
+      name.clear();
+      if (element == "rte") {
+        routes.emplace_back();
+      }
+    } else if (element == "trkseg") {
+      routes.emplace_back();
+    } else if (element == "trkpt" || element == "rtept") {
+      add_point(attributes);
+      in_point = true;
+    } else if (element == "name" && !in_point) {
+      in_name = true;
+    }
+  }
+
+  void end(std::string_view element) {
+    if (element == "trk" || element == "rte") {
+      // The name may come after the segments
+      for (auto route = first_route; route < routes.size(); ++route) {
+        routes[route].name = name;
+      }
+    } else if (element == "name") {
+      in_name = false;
+    } else if (element == "trkpt" || element == "rtept") {
+      in_point = false;
+    }
+  }
+
+  void add_point(const char **attributes) {
+    // Exceptions must not pass through expat, errors stop the parser
+    if (routes.empty()) {
+      stop("point outside of a track or route");
+      return;
+    }
+    std::optional<double> lon;
+    std::optional<double> lat;
+    for (; *attributes != nullptr; attributes += 2) {
+      if (std::strcmp(attributes[0], "lon") == 0) {
+        lon = parse_coordinate(attributes[1]);
+      } else if (std::strcmp(attributes[0], "lat") == 0) {
+        lat = parse_coordinate(attributes[1]);
+      }
+    }
+    if (!lon || !lat) {
+      stop("point without a valid lat and lon");
+      return;
+    }
+    routes.back().points.push_back(ntask::RoutePoint{.lon = *lon, .lat = *lat});
+  }
+
+  /// @return Coordinate in @p text, none if it is not a number
+  static auto parse_coordinate(const char *text) -> std::optional<double> {
+    char *end = nullptr;
+    const auto coordinate = std::strtod(text, &end);
+    const auto *rest = end;
+    while (std::isspace(static_cast<unsigned char>(*rest)) != 0) {
+      ++rest;
+    }
+    if (end == text || *rest != '\0') {
+      return std::nullopt;
+    }
+    return coordinate;
+  }
+
+  void stop(const std::string &message) {
+    error = message;
+    XML_StopParser(parser, XML_FALSE);
+  }
+
+  XML_Parser parser;
+  std::vector<Route> &routes;
+  std::string error;
+  std::size_t first_route = 0;
+  std::string name;
+  bool in_name = false;
+  bool in_point = false;
+};
+
+auto read_gpx(std::ifstream &file) -> std::vector<Route> {
+  const std::unique_ptr<XML_ParserStruct, decltype(&XML_ParserFree)> parser{
+      XML_ParserCreate(nullptr), &XML_ParserFree};
+  if (!parser) {
+    throw std::runtime_error("Can not create an XML parser");
+  }
+  std::vector<Route> routes;
+  GpxReader reader{parser.get(), routes};
+  XML_SetUserData(parser.get(), &reader);
+  XML_SetElementHandler(parser.get(), &GpxReader::start_element,
+                        &GpxReader::end_element);
+  XML_SetCharacterDataHandler(parser.get(), &GpxReader::character_data);
+
+  std::vector<char> buffer(GPX_BUFFER_SIZE);
+  do {
+    file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    if (XML_Parse(parser.get(), buffer.data(),
+                  static_cast<int>(file.gcount()),
+                  file.eof() ? 1 : 0) == XML_STATUS_ERROR) {
+      throw std::runtime_error(
+          "Invalid GPX: " +
+          (reader.get_error().empty()
+               ? std::string{XML_ErrorString(XML_GetErrorCode(parser.get()))}
+               : reader.get_error()));
+    }
+  } while (!file.eof());
+  return routes;
+}
+
+void read_geojson(const nlohmann::json &object, std::vector<Route> &routes,
+                  const Route &feature) {
+  const auto add_line = [&routes, &feature](const nlohmann::json &line) {
+    auto route = feature;
+    for (const auto &position : line) {
+      route.points.push_back(ntask::RoutePoint{
+          .lon = position.at(0).get<double>(),
+          .lat = position.at(1).get<double>()});
+    }
+    routes.push_back(std::move(route));
+  };
+
+  const auto type = object.value("type", std::string{});
+  if (type == "FeatureCollection") {
+    for (const auto &child : object.at("features")) {
+      read_geojson(child, routes, feature);
+    }
+  } else if (type == "Feature") {
+    Route properties;
+    const auto &json_properties = object.value("properties", nlohmann::json{});
+    if (json_properties.is_object()) {
+      properties.name = json_properties.value("name", std::string{});
+      if (json_properties.contains("width")) {
+        properties.width = json_properties["width"].get<double>();
+      }
+    }
+    read_geojson(object.at("geometry"), routes, properties);
+  } else if (type == "GeometryCollection") {
+    for (const auto &geometry : object.at("geometries")) {
+      read_geojson(geometry, routes, feature);
+    }
+  } else if (type == "LineString") {
+    add_line(object.at("coordinates"));
+  } else if (type == "MultiLineString") {
+    for (const auto &line : object.at("coordinates")) {
+      add_line(line);
+    }
+  }
+}
+
+}  // namespace
+
+auto ntask::read_routes(const std::string &path) -> std::vector<Route> {
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    throw std::runtime_error("Can not open " + path);
+  }
+
+  constexpr std::string_view GPX_SUFFIX = ".gpx";
+  if (path.ends_with(GPX_SUFFIX)) {
+    return read_gpx(file);
+  }
+  std::vector<Route> routes;
+  read_geojson(nlohmann::json::parse(file), routes, Route{});
+  return routes;
+}
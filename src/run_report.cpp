@@ -0,0 +1,226 @@
+#include "run_report.hpp"
+
+#include <sys/resource.h>
+
+#include <ctime>
+#include <fstream>
+#include <stdexcept>
+
+#include "nlohmann/json.hpp"
+
+using ntask::RunReport;
+using ntask::ScopedStageTimer;
+
+namespace {
+
+constexpr double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+
+/// @return User and system CPU time of all threads of this process so far
+auto get_cpu_seconds() -> double {
+  constexpr double MICROSECONDS_PER_SECOND = 1e6;
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  const auto to_seconds = [](const timeval &time) {
+    return static_cast<double>(time.tv_sec) +
+           (static_cast<double>(time.tv_usec) / MICROSECONDS_PER_SECOND);
+  };
+  return to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+}
+
+/// @return CPU time of the calling thread so far
+auto get_thread_cpu_seconds() -> double {
+  constexpr double NANOSECONDS_PER_SECOND = 1e9;
+  timespec time{};
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+  return static_cast<double>(time.tv_sec) +
+         (static_cast<double>(time.tv_nsec) / NANOSECONDS_PER_SECOND);
+}
+
+/// @return Peak resident set size of this process in bytes
+auto get_peak_rss() -> std::uint64_t {
+  constexpr std::uint64_t BYTES_PER_KILOBYTE = 1024;
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<std::uint64_t>(usage.ru_maxrss) * BYTES_PER_KILOBYTE;
+}
+
+auto to_seconds(std::chrono::steady_clock::duration duration) -> double {
+  return std::chrono::duration<double>(duration).count();
+}
+
+}  // namespace
+
+ScopedStageTimer::ScopedStageTimer(StageTime &time)
+    : time(time),
+      start_time(std::chrono::steady_clock::now()),
+      start_cpu_seconds(get_thread_cpu_seconds()) {}
+
+ScopedStageTimer::~ScopedStageTimer() {
+  time.wall_seconds +=
+      to_seconds(std::chrono::steady_clock::now() - start_time);
+  time.cpu_seconds += get_thread_cpu_seconds() - start_cpu_seconds;
+}
+
+RunReport::RunReport()
+    : start_time(std::chrono::steady_clock::now()),
+      start_cpu_seconds(get_cpu_seconds()) {}
+
+void RunReport::start_stage(const std::string &name) {
+  stop_stage();
+  running_stage = Stage{.name = name,
+                        .wall_seconds = 0,
+                        .cpu_seconds = get_cpu_seconds(),
+                        .part_of = {}};
+  stage_start_time = std::chrono::steady_clock::now();
+}
+
+void RunReport::stop_stage() {
+  if (!running_stage) {
+    return;
+  }
+
+  running_stage->wall_seconds =
+      to_seconds(std::chrono::steady_clock::now() - stage_start_time);
+  running_stage->cpu_seconds = get_cpu_seconds() - running_stage->cpu_seconds;
+  stages.push_back(std::move(*running_stage));
+  running_stage.reset();
+}
+
+void RunReport::add_stage(const std::string &name, const StageTime &time,
+                          const std::string &part_of) {
+  stages.push_back(Stage{.name = name,
+                         .wall_seconds = time.wall_seconds,
+                         .cpu_seconds = time.cpu_seconds,
+                         .part_of = part_of});
+}
+
+void RunReport::add_info(const std::string &name, const std::string &value) {
+  infos.push_back(Value{.name = name, .value = value});
+}
+
+void RunReport::add_count(const std::string &name, std::uint64_t count,
+                          const std::string &rate_stage) {
+  std::optional<double> per_second;
+  if (!rate_stage.empty()) {
+    const auto wall_seconds = get_wall_seconds(rate_stage);
+    if (wall_seconds > 0) {
+      per_second = static_cast<double>(count) / wall_seconds;
+    }
+  }
+  counts.push_back(
+      Count{.name = name, .count = count, .per_second = per_second});
+}
+
+void RunReport::add_memory(const std::string &name, std::uint64_t bytes) {
+  memories.push_back(Memory{.name = name, .bytes = bytes});
+}
+
+void RunReport::add_pipeline(const PipelineStats &stats) {
+  pipeline_stages.push_back(PipelineStage{.name = "read", .stats = stats.read});
+  pipeline_stages.push_back(
+      PipelineStage{.name = "locate", .stats = stats.locate});
+  pipeline_stages.push_back(
+      PipelineStage{.name = "detect", .stats = stats.detect});
+}
+
+void RunReport::finish(std::uint64_t input_size) {
+  stop_stage();
+  total.wall_seconds =
+      to_seconds(std::chrono::steady_clock::now() - start_time);
+  total.cpu_seconds = get_cpu_seconds() - start_cpu_seconds;
+  peak_rss = get_peak_rss();
+  this->input_size = input_size;
+}
+
+void RunReport::print(std::ostream &out) const {
+  for (const auto &[name, value] : infos) {
+    out << name << ": " << value << '\n';
+  }
+  for (const auto &[name, wall_seconds, cpu_seconds, part_of] : stages) {
+    out << "Stage " << name;
+    if (!part_of.empty()) {
+      out << " (part of " << part_of << ")";
+    }
+    out << ": " << wall_seconds << " s wall, " << cpu_seconds << " s CPU\n";
+  }
+  for (const auto &[name, stats] : pipeline_stages) {
+    constexpr double PERCENT = 100;
+    out << "Pipeline stage " << name << ": "
+        << stats.get_utilization() * PERCENT << "% busy ("
+        << to_seconds(stats.busy) << " s busy, " << to_seconds(stats.waiting)
+        << " s waiting, " << stats.buffers << " buffers)\n";
+  }
+  for (const auto &[name, count, per_second] : counts) {
+    out << name << ": " << count;
+    if (per_second) {
+      out << " (" << *per_second << "/s)";
+    }
+    out << '\n';
+  }
+  for (const auto &[name, bytes] : memories) {
+    out << "Memory " << name << ": "
+        << static_cast<double>(bytes) / BYTES_PER_MEGABYTE << " MiB\n";
+  }
+  out << "Peak RSS: " << static_cast<double>(peak_rss) / BYTES_PER_MEGABYTE
+      << " MiB\n";
+  out << "Run time: " << total.wall_seconds << " s wall, "
+      << total.cpu_seconds << " s CPU ("
+      << static_cast<double>(input_size) / BYTES_PER_MEGABYTE /
+             total.wall_seconds
+      << " MiB/s of input)" << std::endl;
+}
+
+void RunReport::write_json(const std::string &path) const {
+  nlohmann::json report;
+  for (const auto &[name, value] : infos) {
+    report["info"][name] = value;
+  }
+  report["stages"] = nlohmann::json::array();
+  for (const auto &[name, wall_seconds, cpu_seconds, part_of] : stages) {
+    nlohmann::json stage{{"name", name},
+                         {"wall_seconds", wall_seconds},
+                         {"cpu_seconds", cpu_seconds}};
+    if (!part_of.empty()) {
+      stage["part_of"] = part_of;
+    }
+    report["stages"].push_back(stage);
+  }
+  for (const auto &[name, stats] : pipeline_stages) {
+    report["pipeline"].push_back(
+        {{"name", name},
+         {"busy_seconds", to_seconds(stats.busy)},
+         {"waiting_seconds", to_seconds(stats.waiting)},
+         {"utilization", stats.get_utilization()},
+         {"buffers", stats.buffers}});
+  }
+  report["counts"] = nlohmann::json::object();
+  for (const auto &[name, count, per_second] : counts) {
+    report["counts"][name] = count;
+    if (per_second) {
+      report["counts"][name + "_per_second"] = *per_second;
+    }
+  }
+  report["memory_bytes"] = nlohmann::json::object();
+  for (const auto &[name, bytes] : memories) {
+    report["memory_bytes"][name] = bytes;
+  }
+  report["peak_rss_bytes"] = peak_rss;
+  report["wall_seconds"] = total.wall_seconds;
+  report["cpu_seconds"] = total.cpu_seconds;
+  report["input_bytes"] = input_size;
+
+  std::ofstream file{path};
+  if (!file) {
+    throw std::runtime_error("Can not open " + path);
+  }
+  file << report.dump(2) << '\n';
+}
+
+auto RunReport::get_wall_seconds(const std::string &name) const -> double {
+  for (const auto &stage : stages) {
+    if (stage.name == name) {
+      return stage.wall_seconds;
+    }
+  }
+  return 0;
+}
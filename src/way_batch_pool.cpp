@@ -0,0 +1,121 @@
+#include "way_batch_pool.hpp"
+
+using ntask::BendDetector;
+using ntask::WayBatchPool;
+
+namespace {
+
+/// @brief Queued batches per worker, enough to keep the workers busy while
+/// bounding the memory held by batches not yet scanned
+constexpr std::size_t BATCHES_PER_WORKER = 2;
+
+}  // namespace
+
+WayBatchPool::WayBatchPool(const BendDetector &detector,
+                           std::size_t thread_count)
+    : workers(thread_count,
+              Worker{.detector = detector, .dangerous_bends = {}}),
+      queue_capacity(thread_count * BATCHES_PER_WORKER) {
+  threads.reserve(thread_count);
+  for (auto &worker : workers) {
+    threads.emplace_back([this, &worker] { work(worker); });
+  }
+}
+
+WayBatchPool::~WayBatchPool() { stop(); }
+
+void WayBatchPool::submit(WayBatch batch) {
+  std::unique_lock lock{mutex};
+  queue_changed.wait(lock, [this] {
+    return queue.size() < queue_capacity || error != nullptr;
+  });
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+  queue.emplace_back(next_sequence++, std::move(batch));
+  queue_changed.notify_all();
+}
+
+auto WayBatchPool::take_completed()
+    -> std::vector<std::vector<BendDetector::Bend>> {
+  std::vector<std::vector<BendDetector::Bend>> results;
+  const std::lock_guard lock{mutex};
+  auto batch = completed.begin();
+  while (batch != completed.end() && batch->first == next_completed) {
+    results.push_back(std::move(batch->second));
+    batch = completed.erase(batch);
+    ++next_completed;
+  }
+  return results;
+}
+
+auto WayBatchPool::finish()
+    -> std::vector<std::vector<BendDetector::Bend>> {
+  stop();
+  if (error != nullptr) {
+    std::rethrow_exception(error);
+  }
+  return take_completed();
+}
+
+auto WayBatchPool::get_counters() const -> BendDetector::Counters {
+  BendDetector::Counters counters;
+  for (const auto &worker : workers) {
+    counters += worker.detector.get_counters();
+  }
+  return counters;
+}
+
+void WayBatchPool::work(Worker &worker) {
+  while (true) {
+    std::pair<std::size_t, WayBatch> item;
+    {
+      std::unique_lock lock{mutex};
+      queue_changed.wait(lock, [this] { return !queue.empty() || stopped; });
+      if (queue.empty()) {
+        return;
+      }
+      item = std::move(queue.front());
+      queue.pop_front();
+      queue_changed.notify_all();
+    }
+
+    auto &[sequence, batch] = item;
+    try {
+      for (std::size_t way = 0; way < batch.ways.size(); ++way) {
+        const auto bend_count = worker.dangerous_bends.size();
+        worker.detector.detect(batch.ways[way], batch.profiles[way],
+                               worker.dangerous_bends);
+        for (auto bend = bend_count; bend < worker.dangerous_bends.size();
+             ++bend) {
+          worker.dangerous_bends[bend].way_id = batch.way_ids[way];
+        }
+      }
+    } catch (...) {
+      const std::lock_guard lock{mutex};
+      if (error == nullptr) {
+        error = std::current_exception();
+      }
+      queue.clear();
+      queue_changed.notify_all();
+      return;
+    }
+
+    const std::lock_guard lock{mutex};
+    completed.emplace(sequence, std::move(worker.dangerous_bends));
+    worker.dangerous_bends = {};
+  }
+}
+
+void WayBatchPool::stop() {
+  {
+    const std::lock_guard lock{mutex};
+    stopped = true;
+  }
+  queue_changed.notify_all();
+  for (auto &thread : threads) {
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+}
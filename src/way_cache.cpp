@@ -0,0 +1,209 @@
+#include "way_cache.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <type_traits>
+
+#include "fnv_hash.hpp"
+
+using ntask::WayCache;
+using ntask::WayCacheKey;
+using ntask::WayCacheWriter;
+
+static_assert(std::is_trivially_copyable_v<osmium::NodeRef>,
+              "Node refs are stored in the cache as raw bytes");
+
+namespace {
+
+constexpr std::size_t HASH_CHUNK_SIZE = std::size_t{1} << 20U;
+
+/// @brief Hashed before the rules of each profile to tell apart where they
+/// belong
+constexpr char PROFILE_SEPARATOR = 0x1e;
+
+auto hash_file(const std::string &path) -> std::uint64_t {
+  std::ifstream file{path, std::ios::binary};
+  if (!file) {
+    throw std::runtime_error("Can not open " + path);
+  }
+
+  std::uint64_t hash = ntask::FNV_OFFSET_BASIS;
+  std::vector<char> chunk(HASH_CHUNK_SIZE);
+  while (file) {
+    file.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    hash = ntask::fnv_hash_bytes(
+        hash, {chunk.data(), static_cast<std::size_t>(file.gcount())});
+  }
+  return hash;
+}
+
+template <typename T>
+auto raw_bytes(std::span<const T> values) -> std::span<const char> {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return {reinterpret_cast<const char *>(values.data()), values.size_bytes()};
+}
+
+template <typename T>
+auto from_bytes(std::span<const std::byte> bytes, std::size_t count)
+    -> std::span<const T> {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  return {reinterpret_cast<const T *>(bytes.data()), count};
+}
+
+}  // namespace
+
+auto WayCacheKey::make(const std::string &input_file,
+                       const std::vector<FilterRules> &profiles,
+                       std::uint64_t boundary_hash) -> WayCacheKey {
+  return WayCacheKey{
+      .input_hash = hash_file(input_file),
+      .input_mtime = static_cast<std::int64_t>(
+          std::filesystem::last_write_time(input_file)
+              .time_since_epoch()
+              .count()),
+      .filter_hash = fnv_hash_value(hash_filters(profiles), boundary_hash)};
+}
+
+auto WayCacheKey::hash_filters(const std::vector<FilterRules> &profiles)
+    -> std::uint64_t {
+  std::uint64_t filter_hash = FNV_OFFSET_BASIS;
+  for (const auto &profile : profiles) {
+    filter_hash = fnv_hash_bytes(filter_hash, {&PROFILE_SEPARATOR, 1});
+    for (const auto &highway_tag : profile.highway_tags) {
+      filter_hash = fnv_hash_string(filter_hash, highway_tag);
+    }
+    for (const auto &rule : profile.blacklisted_tags) {
+      filter_hash = fnv_hash_value(fnv_hash_string(filter_hash, rule.key),
+                                   rule.match);
+      filter_hash = fnv_hash_string(filter_hash, rule.value);
+    }
+  }
+  return filter_hash;
+}
+
+auto WayCache::load(const std::string &path, const WayCacheKey &key)
+    -> std::optional<WayCache> {
+  Header header{};
+  {
+    std::ifstream file{path, std::ios::binary};
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof header)) {
+      return std::nullopt;
+    }
+  }
+  if (header.magic != MAGIC || header.version != VERSION ||
+      !(header.key == key)) {
+    return std::nullopt;
+  }
+
+  const auto size = sizeof(Header) +
+                    header.node_count * sizeof(osmium::NodeRef) +
+                    header.way_count * sizeof(osmium::object_id_type) +
+                    header.way_count * sizeof(ntask::ProfileMask) +
+                    (header.way_count + 1) * sizeof(std::uint64_t);
+  if (std::filesystem::file_size(path) != size) {
+    return std::nullopt;
+  }
+
+  const int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    return std::nullopt;
+  }
+  try {
+    osmium::util::MemoryMapping mapping{
+        size, osmium::util::MemoryMapping::mapping_mode::readonly, descriptor};
+    ::close(descriptor);
+    return WayCache{std::move(mapping), header};
+  } catch (...) {
+    ::close(descriptor);
+    throw;
+  }
+}
+
+WayCache::WayCache(osmium::util::MemoryMapping mapping, const Header &header)
+    : mapping(std::move(mapping)) {
+  const std::span<const std::byte> bytes{
+      this->mapping.get_addr<const std::byte>(), this->mapping.size()};
+  auto section = bytes.subspan(sizeof(Header));
+  node_refs = from_bytes<osmium::NodeRef>(section, header.node_count);
+  section = section.subspan(node_refs.size_bytes());
+  way_ids = from_bytes<osmium::object_id_type>(section, header.way_count);
+  section = section.subspan(way_ids.size_bytes());
+  way_profiles = from_bytes<ProfileMask>(section, header.way_count);
+  section = section.subspan(way_profiles.size_bytes());
+  offsets = from_bytes<std::uint64_t>(section, header.way_count + 1);
+}
+
+auto WayCache::size() const noexcept -> std::size_t { return way_ids.size(); }
+
+auto WayCache::way_id(std::size_t index) const noexcept
+    -> osmium::object_id_type {
+  return way_ids[index];
+}
+
+auto WayCache::nodes(std::size_t index) const noexcept
+    -> std::span<const osmium::NodeRef> {
+  return node_refs.subspan(offsets[index], offsets[index + 1] - offsets[index]);
+}
+
+auto WayCache::profiles(std::size_t index) const noexcept
+    -> ntask::ProfileMask {
+  return way_profiles[index];
+}
+
+WayCacheWriter::WayCacheWriter(std::string path, const WayCacheKey &key,
+                               const WayFilter &way_filter)
+    : path(std::move(path)),
+      temporary_path(this->path + ".tmp"),
+      file(temporary_path, std::ios::binary | std::ios::trunc),
+      way_filter(way_filter),
+      header{.magic = WayCache::MAGIC,
+             .version = WayCache::VERSION,
+             .key = key,
+             .way_count = 0,
+             .node_count = 0},
+      offsets{0} {
+  if (!file) {
+    throw std::runtime_error("Can not create " + temporary_path);
+  }
+  // Placeholder, the counts are only known in close()
+  write(raw_bytes(std::span<const WayCache::Header>{&header, 1}));
+}
+
+void WayCacheWriter::way(const osmium::Way &way) {
+  const auto profiles = way_filter.match(way);
+  if (profiles == 0) {
+    return;
+  }
+
+  const std::span<const osmium::NodeRef> nodes{way.nodes().cbegin(),
+                                               way.nodes().cend()};
+  write(raw_bytes(nodes));
+  way_ids.push_back(way.id());
+  way_profiles.push_back(profiles);
+  offsets.push_back(offsets.back() + nodes.size());
+}
+
+void WayCacheWriter::close() {
+  header.way_count = way_ids.size();
+  header.node_count = offsets.back();
+
+  write(raw_bytes(std::span<const osmium::object_id_type>{way_ids}));
+  write(raw_bytes(std::span<const ntask::ProfileMask>{way_profiles}));
+  write(raw_bytes(std::span<const std::uint64_t>{offsets}));
+  file.seekp(0);
+  write(raw_bytes(std::span<const WayCache::Header>{&header, 1}));
+  file.close();
+  if (!file) {
+    throw std::runtime_error("Failed to write " + temporary_path);
+  }
+
+  std::filesystem::rename(temporary_path, path);
+}
+
+void WayCacheWriter::write(std::span<const char> bytes) {
+  file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+}
@@ -0,0 +1,99 @@
+#include "way_filter.hpp"
+
+#include <stdexcept>
+
+using ntask::WayFilter;
+
+namespace {
+
+constexpr std::string_view HIGHWAY_KEY = "highway";
+
+auto get_first_byte(std::string_view value) -> std::size_t {
+  return value.empty() ? 0 : static_cast<unsigned char>(value.front());
+}
+
+}  // namespace
+
+WayFilter::WayFilter(const std::vector<std::string> &highway_tags,
+                     const std::vector<TagRule> &blacklisted_tags)
+    : WayFilter(std::vector<FilterRules>{
+          FilterRules{.highway_tags = highway_tags,
+                      .blacklisted_tags = blacklisted_tags}}) {}
+
+WayFilter::WayFilter(const std::vector<FilterRules> &profiles) {
+  if (profiles.size() > MAX_PROFILES) {
+    throw std::runtime_error("At most " + std::to_string(MAX_PROFILES) +
+                             " profiles are supported");
+  }
+
+  key_rules[std::string{HIGHWAY_KEY}];
+  for (std::size_t profile = 0; profile < profiles.size(); ++profile) {
+    const ProfileMask mask = ProfileMask{1} << profile;
+    all_profiles |= mask;
+    for (const auto &highway_tag : profiles[profile].highway_tags) {
+      highway_values[highway_tag] |= mask;
+    }
+
+    for (const auto &rule : profiles[profile].blacklisted_tags) {
+      auto &rules = key_rules[rule.key];
+      switch (rule.match) {
+        case TagRule::Match::value:
+          rules.blacklisted_values[rule.value] |= mask;
+          break;
+        case TagRule::Match::any_value:
+          rules.blacklists_any_value |= mask;
+          break;
+        case TagRule::Match::value_regex:
+          rules.blacklisted_regexes.emplace_back(
+              std::regex{rule.value, std::regex::optimize}, mask);
+          break;
+      }
+    }
+  }
+
+  for (const auto &[key, rules] : key_rules) {
+    first_key_bytes.set(get_first_byte(key));
+  }
+}
+
+auto WayFilter::match(const osmium::Way &way) const -> ProfileMask {
+  ProfileMask highway = 0;
+  ProfileMask blacklisted = 0;
+  for (const auto &tag : way.tags()) {
+    const std::string_view key{tag.key()};
+    if (!first_key_bytes.test(get_first_byte(key))) {
+      continue;
+    }
+    const auto rules = key_rules.find(key);
+    if (rules == key_rules.end()) {
+      continue;
+    }
+
+    const std::string_view value{tag.value()};
+    blacklisted |= rules->second.blacklists_any_value |
+                   get_mask(rules->second.blacklisted_values, value);
+    for (const auto &[regex, mask] : rules->second.blacklisted_regexes) {
+      if ((blacklisted & mask) != mask &&
+          std::regex_match(value.begin(), value.end(), regex)) {
+        blacklisted |= mask;
+      }
+    }
+    if (blacklisted == all_profiles) {
+      return 0;
+    }
+    if (key == HIGHWAY_KEY) {
+      highway |= get_mask(highway_values, value);
+    }
+  }
+  return highway & ~blacklisted;
+}
+
+auto WayFilter::accepts(const osmium::Way &way) const -> bool {
+  return match(way) != 0;
+}
+
+auto WayFilter::get_mask(const ValueMasks &masks, std::string_view value)
+    -> ProfileMask {
+  const auto mask = masks.find(value);
+  return mask == masks.end() ? 0 : mask->second;
+}
@@ -0,0 +1,20 @@
+#include "way_nodes.hpp"
+
+using ntask::WayNodeCollector;
+
+WayNodeCollector::WayNodeCollector(const WayFilter &way_filter)
+    : way_filter(way_filter) {}
+
+void WayNodeCollector::way(const osmium::Way &way) {
+  if (!way_filter.accepts(way)) {
+    return;
+  }
+
+  for (const auto &node : way.nodes()) {
+    node_ids.set(node.positive_ref());
+  }
+}
+
+auto WayNodeCollector::get_node_ids() const noexcept -> const NodeIdSet & {
+  return node_ids;
+}
@@ -0,0 +1,106 @@
+#include "way_simplifier.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <osmium/geom/haversine.hpp>
+#include <stdexcept>
+
+using ntask::WaySimplifier;
+
+WaySimplifier::WaySimplifier(double tolerance)
+    : tolerance_squared(tolerance * tolerance) {
+  if (tolerance < 0) {
+    throw std::runtime_error("The simplification tolerance must not be "
+                             "negative");
+  }
+}
+
+auto WaySimplifier::simplify(std::span<const osmium::NodeRef> nodes)
+    -> std::span<const osmium::NodeRef> {
+  keep.assign(nodes.size(), 1);
+  std::size_t begin = 0;
+  for (std::size_t index = 0; index <= nodes.size(); ++index) {
+    if (index == nodes.size() || !nodes[index].location().valid()) {
+      simplify_run(nodes, begin, index);
+      begin = index + 1;
+    }
+  }
+
+  simplified.clear();
+  for (std::size_t index = 0; index < nodes.size(); ++index) {
+    if (keep[index] != 0) {
+      simplified.push_back(nodes[index]);
+    }
+  }
+  return simplified;
+}
+
+void WaySimplifier::simplify_run(std::span<const osmium::NodeRef> nodes,
+                                 std::size_t begin, std::size_t end) {
+  constexpr std::size_t MIN_RUN_SIZE = 3;
+  if (end < begin + MIN_RUN_SIZE) {
+    return;
+  }
+
+  points.clear();
+  for (auto index = begin; index < end; ++index) {
+    const auto &location = nodes[index].location();
+    const auto latitude = osmium::geom::deg_to_rad(location.lat());
+    points.push_back(Point{
+        .x = osmium::geom::deg_to_rad(location.lon()) *
+             osmium::geom::haversine::EARTH_RADIUS_IN_METERS,
+        .y = latitude * osmium::geom::haversine::EARTH_RADIUS_IN_METERS,
+        .scale = std::cos(latitude)});
+  }
+  for (auto index = begin + 1; index + 1 < end; ++index) {
+    keep[index] = 0;
+  }
+
+  // Keep the node farthest from the segment between two kept nodes while it
+  // is beyond the tolerance, then look at both halves
+  ranges.clear();
+  ranges.emplace_back(0, points.size() - 1);
+  while (!ranges.empty()) {
+    const auto [first, last] = ranges.back();
+    ranges.pop_back();
+    const auto &from = points[first];
+    const auto &to = points[last];
+
+    double max_distance_squared = 0;
+    auto farthest = first;
+    for (auto index = first + 1; index < last; ++index) {
+      // Projected at the latitude of the node, where the segment is closest
+      // to it if it is within the tolerance, however long the way is
+      const auto &point = points[index];
+      const auto segment_x = (to.x - from.x) * point.scale;
+      const auto segment_y = to.y - from.y;
+      const auto length_squared =
+          (segment_x * segment_x) + (segment_y * segment_y);
+      const auto x = (point.x - from.x) * point.scale;
+      const auto y = point.y - from.y;
+      const auto share =
+          length_squared > 0
+              ? std::clamp(((x * segment_x) + (y * segment_y)) /
+                               length_squared,
+                           0.0, 1.0)
+              : 0.0;
+      const auto delta_x = x - (share * segment_x);
+      const auto delta_y = y - (share * segment_y);
+      const auto distance_squared = (delta_x * delta_x) + (delta_y * delta_y);
+      if (distance_squared > max_distance_squared) {
+        max_distance_squared = distance_squared;
+        farthest = index;
+      }
+    }
+
+    if (max_distance_squared > tolerance_squared) {
+      keep[begin + farthest] = 1;
+      if (farthest - first > 1) {
+        ranges.emplace_back(first, farthest);
+      }
+      if (last - farthest > 1) {
+        ranges.emplace_back(farthest, last);
+      }
+    }
+  }
+}
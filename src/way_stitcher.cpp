@@ -0,0 +1,173 @@
+#include "way_stitcher.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iterator>
+#include <utility>
+#include <osmium/geom/haversine.hpp>
+
+#include "fnv_hash.hpp"
+
+using ntask::WayStitcher;
+
+namespace {
+
+/// @brief Tags two continuing ways share
+constexpr std::array<const char *, 3> KEY_TAGS{"highway", "ref", "name"};
+
+}  // namespace
+
+WayStitcher::WayStitcher(const std::vector<BendDetector::Thresholds> &profiles,
+                         BendDetector::DistanceModel distance_model,
+                         std::size_t max_endpoints)
+    : detector(profiles, distance_model),
+      max_endpoints(std::max<std::size_t>(max_endpoints, 1)) {
+  for (const auto &profile : profiles) {
+    max_distance = std::max(max_distance, profile.distance_threshold);
+  }
+}
+
+auto WayStitcher::get_key(const osmium::TagList &tags) -> std::uint64_t {
+  auto hash = FNV_OFFSET_BASIS;
+  for (const auto *key : KEY_TAGS) {
+    hash = fnv_hash_string(hash, tags.get_value_by_key(key, ""));
+  }
+  return hash;
+}
+
+void WayStitcher::add(osmium::object_id_type way_id,
+                      std::span<const osmium::NodeRef> nodes,
+                      ProfileMask profiles, std::uint64_t key,
+                      std::vector<BendDetector::Bend> &dangerous_bends) {
+  constexpr std::size_t MIN_NODE_COUNT = 2;
+  if (nodes.size() < MIN_NODE_COUNT) {
+    return;
+  }
+  collect_tail(nodes, true);
+  add_endpoint(way_id, nodes.front(), profiles, key, dangerous_bends);
+  collect_tail(nodes, false);
+  add_endpoint(way_id, nodes.back(), profiles, key, dangerous_bends);
+}
+
+auto WayStitcher::get_counters() const noexcept -> const Counters & {
+  return counters;
+}
+
+auto WayStitcher::get_detector_counters() const noexcept
+    -> const BendDetector::Counters & {
+  return detector.get_counters();
+}
+
+auto WayStitcher::used_memory() const -> std::size_t {
+  // A node of the hash map holds its value and the pointer to the next one
+  using SlotNode = std::pair<void *, decltype(slots)::value_type>;
+  return (endpoints.capacity() * sizeof(Endpoint)) +
+         (tails.capacity() * sizeof(osmium::Location)) +
+         (slots.size() * sizeof(SlotNode)) +
+         (slots.bucket_count() * sizeof(void *));
+}
+
+auto WayStitcher::SlotKeyHash::operator()(
+    const SlotKey &slot_key) const noexcept -> std::size_t {
+  return fnv_hash_value(slot_key.key, slot_key.node_id);
+}
+
+void WayStitcher::collect_tail(std::span<const osmium::NodeRef> nodes,
+                               bool forward) {
+  tail.clear();
+  const auto &end = forward ? nodes.front() : nodes.back();
+  if (!end.location().valid()) {
+    return;
+  }
+  tail.push_back(end.location());
+  // The other end of a closed way is the same node
+  const auto step_count = nodes.front().ref() == nodes.back().ref()
+                              ? nodes.size() - 1
+                              : nodes.size();
+  // Up to the first node beyond the distance threshold, which ends the
+  // window; the detector decides with its own distance model
+  for (std::size_t step = 1;
+       step < step_count && tail.size() < MAX_TAIL_NODES; ++step) {
+    const auto &location =
+        nodes[forward ? step : nodes.size() - 1 - step].location();
+    if (!location.valid()) {
+      break;  // Ends the window like in the detector
+    }
+    tail.push_back(location);
+    if (osmium::geom::haversine::distance(end.location(), location) >
+        max_distance) {
+      break;
+    }
+  }
+}
+
+void WayStitcher::add_endpoint(
+    osmium::object_id_type way_id, const osmium::NodeRef &node,
+    ProfileMask profiles, std::uint64_t key,
+    std::vector<BendDetector::Bend> &dangerous_bends) {
+  constexpr std::size_t MIN_TAIL_SIZE = 2;
+  if (tail.size() < MIN_TAIL_SIZE) {
+    return;  // Nothing to form an angle with
+  }
+
+  const SlotKey slot_key{.node_id = node.ref(), .key = key};
+  const auto waiting = slots.find(slot_key);
+  if (waiting != slots.end()) {
+    const auto &endpoint = endpoints[waiting->second];
+    const auto common_profiles = endpoint.profiles & profiles;
+    if (common_profiles == 0) {
+      // The same road without a common profile, e.g. a one-way part left
+      // out by a profile: the waiting end keeps waiting, this one is lost
+      ++counters.dropped_count;
+      return;
+    }
+
+    // The waiting tail backwards up to the shared node, then the new tail
+    const auto *waiting_tail = &tails[waiting->second * MAX_TAIL_NODES];
+    stitched.assign(std::make_reverse_iterator(waiting_tail +
+                                               endpoint.tail_size),
+                    std::make_reverse_iterator(waiting_tail));
+    stitched.insert(stitched.end(), tail.begin() + 1, tail.end());
+    const auto shared_index = std::size_t{endpoint.tail_size} - 1;
+    slots.erase(waiting);
+    ++counters.junction_count;
+
+    stitched_bends.clear();
+    detector.detect(stitched, common_profiles, stitched_bends);
+    for (const auto &bend : stitched_bends) {
+      if (static_cast<std::size_t>(bend.node.ref()) == shared_index) {
+        dangerous_bends.push_back(BendDetector::Bend{
+            .node = node,
+            .profile = bend.profile,
+            .min_angle = bend.min_angle,
+            .way_id = way_id});
+      }
+    }
+    return;
+  }
+
+  // Wait in a new slot until all are taken, then in the oldest one
+  std::size_t slot = endpoints.size();
+  if (slot < max_endpoints) {
+    endpoints.emplace_back();
+    tails.resize(endpoints.size() * MAX_TAIL_NODES);
+  } else {
+    slot = next_slot;
+    next_slot = (next_slot + 1) % max_endpoints;
+    const auto &oldest = endpoints[slot];
+    const auto dropped =
+        slots.find(SlotKey{.node_id = oldest.node_id, .key = oldest.key});
+    if (dropped != slots.end() && dropped->second == slot) {
+      slots.erase(dropped);
+      ++counters.dropped_count;
+    }
+  }
+  endpoints[slot] =
+      Endpoint{.node_id = node.ref(),
+               .key = key,
+               .profiles = profiles,
+               .tail_size = static_cast<std::uint32_t>(tail.size())};
+  std::copy(tail.begin(), tail.end(), &tails[slot * MAX_TAIL_NODES]);
+  slots.emplace(slot_key, slot);
+  ++counters.endpoint_count;
+}
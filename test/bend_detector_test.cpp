@@ -0,0 +1,286 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "synthetic_roads.hpp"
+
+namespace {
+
+constexpr std::uint64_t SEED = 42;
+constexpr std::size_t WAY_COUNT = 50;
+
+using Model = ntask::BendDetector::DistanceModel;
+using Thresholds = ntask::BendDetector::Thresholds;
+
+constexpr std::array DISTANCE_THRESHOLDS{20.0, 50.0, 100.0};
+constexpr std::array ANGLE_THRESHOLDS{90.0, 120.0, 135.0, 150.0, 170.0};
+
+/// @brief Roads turning a little at every node with a rare hairpin, most of
+/// them are proven free of bends by small angle thresholds
+constexpr ntask::bench::RoadShape STRAIGHT_ROADS{
+    .node_count = 100,
+    .node_spacing = 15,
+    .turn_deviation = 2,
+    .hairpin_share = 0.002};
+
+/// @brief Roads with the curvature of the benchmarks, hardly any of them is
+/// skipped
+constexpr ntask::bench::RoadShape CURVY_ROADS{.node_count = 100,
+                                              .node_spacing = 15,
+                                              .turn_deviation = 10,
+                                              .hairpin_share = 0.01};
+
+/// @brief Where the generated ways are moved to
+struct Placement {
+  /// @brief Latitude of the first node of each way, as generated if not set
+  std::optional<double> latitude;
+
+  /// @brief Longitude of the first node of each way, as generated if not set
+  std::optional<double> longitude;
+
+  /// @brief Every this many nodes has no location, 0 for none
+  std::size_t invalid_interval = 0;
+};
+
+/// @return Generated ways, moved as a whole to @p placement
+auto make_ways(const ntask::bench::RoadShape &shape,
+               const Placement &placement = {})
+    -> std::vector<std::vector<osmium::NodeRef>> {
+  constexpr double HALF_TURN = 180;
+  constexpr double MAX_LATITUDE = 89;
+  ntask::bench::SyntheticRoads roads{shape, SEED};
+  std::vector<std::vector<osmium::NodeRef>> ways;
+  for (std::size_t way = 0; way < WAY_COUNT; ++way) {
+    auto nodes = roads.next_way();
+    const auto first = nodes.front().location();
+    const auto delta_lat = placement.latitude.value_or(first.lat()) -
+                           first.lat();
+    const auto delta_lon = placement.longitude.value_or(first.lon()) -
+                           first.lon();
+    for (std::size_t index = 0; index < nodes.size(); ++index) {
+      auto &node = nodes[index];
+      if (placement.invalid_interval != 0 &&
+          index % placement.invalid_interval == 0) {
+        node.set_location(osmium::Location{});
+        continue;
+      }
+      auto lon = node.location().lon() + delta_lon;
+      if (std::abs(lon) > HALF_TURN) {
+        lon -= std::copysign(2 * HALF_TURN, lon);
+      }
+      const auto lat = std::clamp(node.location().lat() + delta_lat,
+                                  -MAX_LATITUDE, MAX_LATITUDE);
+      node.set_location(osmium::Location{lon, lat});
+    }
+    ways.push_back(std::move(nodes));
+  }
+  return ways;
+}
+
+/// @return Straight ways turning at @p corner_count corners @p corner_spacing
+/// meter apart, in total by a little less to a little more than 180° minus
+/// each angle threshold. The angle at a single corner is 180° minus its
+/// turn, where the check of the curvature is tight.
+auto make_corner_ways(std::size_t corner_count, double corner_spacing)
+    -> std::vector<std::vector<osmium::NodeRef>> {
+  constexpr double NODE_SPACING = 10;
+  constexpr double STRAIGHT_LENGTH = 120;
+  constexpr double TURN_STEP = 0.25;
+  constexpr int TURN_STEPS = 6;
+  const auto step = NODE_SPACING /
+                    osmium::geom::haversine::EARTH_RADIUS_IN_METERS;
+  const auto straight_steps =
+      static_cast<std::size_t>(STRAIGHT_LENGTH / NODE_SPACING);
+  const auto corner_steps =
+      static_cast<std::size_t>(corner_spacing / NODE_SPACING);
+
+  std::vector<double> turns;
+  for (const auto angle_threshold : ANGLE_THRESHOLDS) {
+    for (auto turn_step = -TURN_STEPS; turn_step <= TURN_STEPS; ++turn_step) {
+      turns.push_back(180 - angle_threshold + (turn_step * TURN_STEP));
+    }
+  }
+
+  std::vector<std::vector<osmium::NodeRef>> ways;
+  osmium::object_id_type node_id = 1;
+  for (const auto turn : turns) {
+    double latitude = 45;
+    double longitude = 10;
+    // In another direction for each way
+    auto heading = static_cast<double>(ways.size());
+    std::vector<osmium::NodeRef> nodes;
+    const auto node_count =
+        (2 * straight_steps) + ((corner_count - 1) * corner_steps) + 1;
+    for (std::size_t index = 0; index < node_count; ++index) {
+      nodes.emplace_back(node_id++, osmium::Location{longitude, latitude});
+      if (index >= straight_steps &&
+          (index - straight_steps) % corner_steps == 0 &&
+          (index - straight_steps) / corner_steps < corner_count) {
+        // Turns to the left or right in turn
+        heading += osmium::geom::deg_to_rad(
+            (ways.size() % 2 == 0 ? turn : -turn) /
+            static_cast<double>(corner_count));
+      }
+      latitude += osmium::geom::rad_to_deg(step * std::cos(heading));
+      longitude += osmium::geom::rad_to_deg(
+          step * std::sin(heading) /
+          std::cos(osmium::geom::deg_to_rad(latitude)));
+    }
+    ways.push_back(std::move(nodes));
+  }
+  return ways;
+}
+
+/// @brief Node ID, profile and smallest angle of a found node
+using Found = std::tuple<osmium::object_id_type, std::size_t, double>;
+
+/// @brief Scan @p ways for varying profiles, with or without the check of
+/// the curvature
+/// @return Found nodes of all ways
+auto detect_all(const std::vector<std::vector<osmium::NodeRef>> &ways,
+                const std::vector<Thresholds> &thresholds, Model model,
+                bool curvature_check,
+                ntask::BendDetector::Counters *counters = nullptr)
+    -> std::vector<Found> {
+  ntask::BendDetector detector{thresholds, model};
+  detector.set_curvature_check(curvature_check);
+  const auto all_profiles =
+      (ntask::ProfileMask{1} << thresholds.size()) - 1;
+  std::vector<ntask::BendDetector::Bend> bends;
+  for (std::size_t way = 0; way < ways.size(); ++way) {
+    // Every combination of profiles in turn
+    detector.detect(ways[way], (way % all_profiles) + 1, bends);
+  }
+  if (counters != nullptr) {
+    *counters = detector.get_counters();
+  }
+
+  std::vector<Found> found;
+  for (const auto &bend : bends) {
+    found.emplace_back(bend.node.ref(), bend.profile, bend.min_angle);
+  }
+  return found;
+}
+
+/// @brief Expect the same nodes with and without the check of the curvature
+/// @return Ways skipped by the check
+auto expect_same_bends(const std::vector<std::vector<osmium::NodeRef>> &ways,
+                       const std::vector<Thresholds> &thresholds)
+    -> std::uint64_t {
+  std::uint64_t skipped_way_count = 0;
+  for (const auto model : {Model::haversine, Model::planar}) {
+    ntask::BendDetector::Counters counters;
+    EXPECT_EQ(detect_all(ways, thresholds, model, true, &counters),
+              detect_all(ways, thresholds, model, false))
+        << "distance model " << static_cast<int>(model);
+    skipped_way_count += counters.skipped_way_count;
+  }
+  return skipped_way_count;
+}
+
+/// @brief Expect the same nodes for single profiles of many thresholds
+/// @return Ways skipped by the check
+auto expect_same_bends_of_thresholds(
+    const std::vector<std::vector<osmium::NodeRef>> &ways) -> std::uint64_t {
+  std::uint64_t skipped_way_count = 0;
+  for (const auto distance_threshold : DISTANCE_THRESHOLDS) {
+    for (const auto angle_threshold : ANGLE_THRESHOLDS) {
+      skipped_way_count += expect_same_bends(
+          ways, {Thresholds{.distance_threshold = distance_threshold,
+                            .angle_threshold = angle_threshold}});
+    }
+  }
+  return skipped_way_count;
+}
+
+// Skipping ways by their curvature never changes the result of a single
+// profile, whatever its thresholds
+TEST(BendDetectorTest, CurvatureCheckKeepsBendsOfThresholds) {
+  EXPECT_GT(expect_same_bends_of_thresholds(make_ways(STRAIGHT_ROADS)), 0U);
+  expect_same_bends_of_thresholds(make_ways(CURVY_ROADS));
+}
+
+// Single corners and corners close enough to share windows, turning just
+// below and above the limit of each angle threshold
+TEST(BendDetectorTest, CurvatureCheckKeepsBendsOfCorners) {
+  for (const auto &[corner_count, corner_spacing] :
+       {std::pair{1U, 10.0}, std::pair{2U, 10.0}, std::pair{2U, 30.0},
+        std::pair{3U, 20.0}}) {
+    EXPECT_GT(expect_same_bends_of_thresholds(
+                  make_corner_ways(corner_count, corner_spacing)),
+              0U);
+  }
+}
+
+// Profiles with different thresholds share the check, in any combination
+TEST(BendDetectorTest, CurvatureCheckKeepsBendsOfProfiles) {
+  const std::vector<Thresholds> thresholds{
+      Thresholds{.distance_threshold = 50, .angle_threshold = 135},
+      Thresholds{.distance_threshold = 20, .angle_threshold = 150},
+      Thresholds{.distance_threshold = 100, .angle_threshold = 90},
+      Thresholds{.distance_threshold = 30, .angle_threshold = 120}};
+  EXPECT_GT(expect_same_bends(make_ways(STRAIGHT_ROADS), thresholds), 0U);
+  expect_same_bends(make_ways(CURVY_ROADS), thresholds);
+}
+
+/// @return Straight roads starting at @p latitude
+auto make_ways_at_latitude(double latitude)
+    -> std::vector<std::vector<osmium::NodeRef>> {
+  return make_ways(STRAIGHT_ROADS, Placement{.latitude = latitude,
+                                             .longitude = std::nullopt,
+                                             .invalid_interval = 0});
+}
+
+// Near and beyond the latitude up to which ways are skipped
+TEST(BendDetectorTest, CurvatureCheckKeepsBendsAtHighLatitude) {
+  const std::vector<Thresholds> thresholds{
+      Thresholds{.distance_threshold = 50, .angle_threshold = 135},
+      Thresholds{.distance_threshold = 20, .angle_threshold = 160}};
+  EXPECT_GT(expect_same_bends(make_ways_at_latitude(65), thresholds), 0U);
+  for (const auto latitude : {69.9, 75.0, 85.0, -69.95}) {
+    expect_same_bends(make_ways_at_latitude(latitude), thresholds);
+  }
+}
+
+// Ways crossing the antimeridian, where longitudes wrap around
+TEST(BendDetectorTest, CurvatureCheckKeepsBendsAcrossAntimeridian) {
+  const std::vector<Thresholds> thresholds{
+      Thresholds{.distance_threshold = 50, .angle_threshold = 135}};
+  for (const auto longitude : {179.99, -179.99}) {
+    for (const auto &shape : {STRAIGHT_ROADS, CURVY_ROADS}) {
+      expect_same_bends(make_ways(shape, Placement{.latitude = 10,
+                                                   .longitude = longitude,
+                                                   .invalid_interval = 0}),
+                        thresholds);
+    }
+  }
+}
+
+// Nodes without a location end windows and stretches of the check alike
+TEST(BendDetectorTest, CurvatureCheckKeepsBendsWithInvalidLocations) {
+  const std::vector<Thresholds> thresholds{
+      Thresholds{.distance_threshold = 50, .angle_threshold = 135},
+      Thresholds{.distance_threshold = 100, .angle_threshold = 150}};
+  for (const auto invalid_interval : {2U, 7U, 50U}) {
+    for (const auto &shape : {STRAIGHT_ROADS, CURVY_ROADS}) {
+      expect_same_bends(
+          make_ways(shape, Placement{.latitude = std::nullopt,
+                                     .longitude = std::nullopt,
+                                     .invalid_interval = invalid_interval}),
+          thresholds);
+    }
+  }
+}
+
+}  // namespace
@@ -0,0 +1,364 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <numbers>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "bend_index.hpp"
+#include "bend_index_writer.hpp"
+
+namespace {
+
+/// @brief Bends of the larger indexes, three levels of the tree
+constexpr std::size_t BEND_COUNT = 2000;
+
+constexpr double MAX_LON = 180;
+
+/// @brief Node IDs of found bends in ascending order
+using NodeIds = std::vector<std::int64_t>;
+
+/// @return @p count locations spread evenly over a box by low discrepancy
+/// sequences, longitudes beyond the antimeridian wrapped around
+auto spread_locations(std::size_t count, double min_lon, double min_lat,
+                      double max_lon, double max_lat)
+    -> std::vector<osmium::Location> {
+  std::vector<osmium::Location> locations;
+  for (std::size_t index = 0; index < count; ++index) {
+    const auto position = static_cast<double>(index);
+    auto lon = min_lon + ((max_lon - min_lon) *
+                          std::fmod(position / std::numbers::phi, 1.0));
+    const auto lat = min_lat + ((max_lat - min_lat) *
+                                std::fmod(position / std::numbers::sqrt2, 1.0));
+    if (lon >= MAX_LON) {
+      lon -= 2 * MAX_LON;
+    }
+    locations.emplace_back(lon, lat);
+  }
+  return locations;
+}
+
+/// @brief Index written to a temporary file, removed after each test
+class BendIndexTest : public ::testing::Test {
+ protected:
+  void TearDown() override { std::filesystem::remove(path); }
+
+  /// @return Index over bends at @p locations, their node IDs counting up
+  /// from 1
+  auto make_index(const std::vector<osmium::Location> &locations)
+      -> ntask::BendIndex {
+    ntask::BendIndexWriter writer{path.string(), false};
+    osmium::object_id_type node_id = 1;
+    for (const auto &location : locations) {
+      writer.write(ntask::BendDetector::Bend{
+          .node = osmium::NodeRef{node_id++, location},
+          .profile = 0,
+          .min_angle = 90,
+          .way_id = 1});
+    }
+    writer.close();
+    return ntask::BendIndex{path.string()};
+  }
+
+  const std::filesystem::path path =
+      std::filesystem::temp_directory_path() /
+      ("ntask_bend_index_test_" +
+       std::string{::testing::UnitTest::GetInstance()
+                       ->current_test_info()
+                       ->name()});
+};
+
+/// @return Bends found by @c BendIndex::query in @p box
+auto query(const ntask::BendIndex &index, const ntask::BendBox &box)
+    -> NodeIds {
+  NodeIds node_ids;
+  index.query(box, [&node_ids](const ntask::BendRecord &record) {
+    node_ids.push_back(record.node_id);
+  });
+  std::sort(node_ids.begin(), node_ids.end());
+  return node_ids;
+}
+
+/// @return Bends in @p box by a scan of all records
+auto scan(const ntask::BendIndex &index, const ntask::BendBox &box)
+    -> NodeIds {
+  NodeIds node_ids;
+  for (const auto &record : index.records()) {
+    if (box.contains(record)) {
+      node_ids.push_back(record.node_id);
+    }
+  }
+  std::sort(node_ids.begin(), node_ids.end());
+  return node_ids;
+}
+
+/// @return Bends found by @c BendIndex::query_radius
+auto query_radius(const ntask::BendIndex &index, double lon, double lat,
+                  double radius) -> NodeIds {
+  NodeIds node_ids;
+  index.query_radius(lon, lat, radius,
+                     [&node_ids](const ntask::BendRecord &record) {
+                       node_ids.push_back(record.node_id);
+                     });
+  std::sort(node_ids.begin(), node_ids.end());
+  return node_ids;
+}
+
+/// @return Bends within @p radius meter by a scan of all records
+auto scan_radius(const ntask::BendIndex &index, double lon, double lat,
+                 double radius) -> NodeIds {
+  NodeIds node_ids;
+  for (const auto &record : index.records()) {
+    if (ntask::BendIndex::get_distance(lon, lat, record.get_lon(),
+                                       record.get_lat()) <= radius) {
+      node_ids.push_back(record.node_id);
+    }
+  }
+  std::sort(node_ids.begin(), node_ids.end());
+  return node_ids;
+}
+
+// Boxes of all sizes find what a scan finds, each bend once
+TEST_F(BendIndexTest, QueriesBoxesLikeScan) {
+  const auto locations = spread_locations(BEND_COUNT, 9, 49, 11, 51);
+  const auto index = make_index(locations);
+  const auto &corner = locations[BEND_COUNT / 2];
+  for (const auto &box :
+       {ntask::BendBox::from_degrees(-MAX_LON, -90, MAX_LON, 90),
+        ntask::BendBox::from_degrees(9.5, 49.5, 10.5, 50.5),
+        ntask::BendBox::from_degrees(9.99, 49.99, 10.01, 50.01),
+        ntask::BendBox::from_degrees(10.5, 48, 10.6, 52),
+        ntask::BendBox::from_degrees(12, 49, 13, 51),
+        // A single bend on all edges
+        ntask::BendBox::from_degrees(corner.lon(), corner.lat(), corner.lon(),
+                                     corner.lat())}) {
+    EXPECT_EQ(query(index, box), scan(index, box));
+  }
+  EXPECT_FALSE(
+      query(index, ntask::BendBox::from_degrees(9.5, 49.5, 10.5, 50.5))
+          .empty());
+}
+
+// Circles of all sizes find what a scan by great-circle distance finds
+TEST_F(BendIndexTest, QueriesRadiusLikeScan) {
+  const auto index = make_index(spread_locations(BEND_COUNT, 9, 49, 11, 51));
+  for (const auto radius : {100.0, 1000.0, 10000.0, 50000.0, 200000.0}) {
+    for (const auto &[lon, lat] :
+         {std::pair{10.0, 50.0}, std::pair{9.0, 49.0}, std::pair{11.2, 50.5}}) {
+      EXPECT_EQ(query_radius(index, lon, lat, radius),
+                scan_radius(index, lon, lat, radius))
+          << radius << " m around " << lon << ", " << lat;
+    }
+  }
+  EXPECT_FALSE(query_radius(index, 10, 50, 10000).empty());
+}
+
+// Circles around a point close to the antimeridian reach the bends on its
+// other side
+TEST_F(BendIndexTest, QueriesRadiusAcrossAntimeridian) {
+  const auto index =
+      make_index(spread_locations(BEND_COUNT, 179.5, -1, 180.5, 1));
+  for (const auto radius : {1000.0, 5000.0, 20000.0, 100000.0}) {
+    for (const auto lon : {179.99, -179.99, 180.0, -180.0}) {
+      EXPECT_EQ(query_radius(index, lon, 0, radius),
+                scan_radius(index, lon, 0, radius))
+          << radius << " m around " << lon;
+    }
+  }
+
+  const auto node_ids = query_radius(index, 179.99, 0, 20000);
+  const auto records = index.records();
+  const auto is_west = [&records](std::int64_t node_id) {
+    return std::any_of(records.begin(), records.end(),
+                       [node_id](const ntask::BendRecord &record) {
+                         return record.node_id == node_id && record.lon < 0;
+                       });
+  };
+  EXPECT_TRUE(std::any_of(node_ids.begin(), node_ids.end(), is_west));
+  EXPECT_FALSE(std::all_of(node_ids.begin(), node_ids.end(), is_west));
+}
+
+// Circles containing a pole or reaching all longitudes near it
+TEST_F(BendIndexTest, QueriesRadiusAroundPoles) {
+  auto locations = spread_locations(BEND_COUNT / 2, -MAX_LON, 89, MAX_LON, 90);
+  const auto south = spread_locations(BEND_COUNT / 2, -MAX_LON, -90, MAX_LON,
+                                      -89);
+  locations.insert(locations.end(), south.begin(), south.end());
+  locations.emplace_back(0.0, 90.0);
+  locations.emplace_back(0.0, -90.0);
+  const auto index = make_index(locations);
+  for (const auto radius : {10000.0, 20000.0, 60000.0, 150000.0}) {
+    for (const auto &[lon, lat] :
+         {std::pair{0.0, 89.9}, std::pair{170.0, 89.5}, std::pair{-45.0, 89.0},
+          std::pair{0.0, 90.0}, std::pair{90.0, -89.95}}) {
+      EXPECT_EQ(query_radius(index, lon, lat, radius),
+                scan_radius(index, lon, lat, radius))
+          << radius << " m around " << lon << ", " << lat;
+    }
+  }
+  EXPECT_FALSE(query_radius(index, 0, 89.9, 20000).empty());
+}
+
+// An index without bends is valid and finds nothing
+TEST_F(BendIndexTest, EmptyIndexFindsNothing) {
+  const auto index = make_index({});
+  EXPECT_TRUE(index.records().empty());
+  EXPECT_TRUE(
+      query(index, ntask::BendBox::from_degrees(-MAX_LON, -90, MAX_LON, 90))
+          .empty());
+  EXPECT_TRUE(query_radius(index, 0, 90, 100000).empty());
+  EXPECT_TRUE(query_radius(index, 10, 50, 1000).empty());
+  const std::vector<ntask::RoutePoint> route{{.lon = 10, .lat = 50},
+                                             {.lon = 10.1, .lat = 50}};
+  EXPECT_TRUE(index.query_corridor(route, 1000).empty());
+}
+
+/// @brief Node ID and distance to the route of a bend along a route
+using RouteBend = std::pair<std::int64_t, double>;
+
+/// @return Bends found by @c BendIndex::query_corridor in the order of their
+/// node IDs, after checking the order of their positions
+auto query_corridor(const ntask::BendIndex &index,
+                    const std::vector<ntask::RoutePoint> &route, double width)
+    -> std::vector<RouteBend> {
+  const auto corridor_bends = index.query_corridor(route, width);
+  EXPECT_TRUE(std::is_sorted(
+      corridor_bends.begin(), corridor_bends.end(),
+      [](const ntask::CorridorBend &left, const ntask::CorridorBend &right) {
+        return left.position < right.position;
+      }));
+  std::vector<RouteBend> bends;
+  for (const auto &bend : corridor_bends) {
+    bends.emplace_back(bend.record->node_id, bend.distance);
+  }
+  std::sort(bends.begin(), bends.end());
+  return bends;
+}
+
+/// @return Distance in meter from @p record to the segment from @p from to
+/// @p to in a plane tangent at the segment, as documented for
+/// @c BendIndex::query_corridor
+auto get_segment_distance(const ntask::RoutePoint &from,
+                          const ntask::RoutePoint &to,
+                          const ntask::BendRecord &record) -> double {
+  constexpr double DEGREE = std::numbers::pi / 180;
+  constexpr double METERS_PER_DEGREE =
+      ntask::BendIndex::EARTH_RADIUS_IN_METERS * DEGREE;
+  const auto lon_delta = [](double from_lon, double to_lon) {
+    return std::remainder(to_lon - from_lon, 2 * MAX_LON);
+  };
+  const auto lon_scale =
+      std::cos((from.lat + to.lat) / 2 * DEGREE) * METERS_PER_DEGREE;
+  const auto segment_x = lon_delta(from.lon, to.lon) * lon_scale;
+  const auto segment_y = (to.lat - from.lat) * METERS_PER_DEGREE;
+  const auto x = lon_delta(from.lon, record.get_lon()) * lon_scale;
+  const auto y = (record.get_lat() - from.lat) * METERS_PER_DEGREE;
+  const auto length_squared = (segment_x * segment_x) + (segment_y * segment_y);
+  const auto share =
+      length_squared > 0
+          ? std::clamp(((x * segment_x) + (y * segment_y)) / length_squared,
+                       0.0, 1.0)
+          : 0.0;
+  return std::hypot(x - (share * segment_x), y - (share * segment_y));
+}
+
+/// @return Bends within @p width meter of the closest segment of @p route by
+/// a scan of all records, in the order of their node IDs
+auto scan_corridor(const ntask::BendIndex &index,
+                   const std::vector<ntask::RoutePoint> &route, double width)
+    -> std::vector<RouteBend> {
+  std::vector<RouteBend> bends;
+  for (const auto &record : index.records()) {
+    // A route of one point has one segment of length 0
+    const auto segment_count = std::max<std::size_t>(route.size(), 2) - 1;
+    auto distance = std::numeric_limits<double>::infinity();
+    for (std::size_t segment = 0; segment < segment_count; ++segment) {
+      distance = std::min(
+          distance,
+          get_segment_distance(route[segment],
+                               route[std::min(segment + 1, route.size() - 1)],
+                               record));
+    }
+    if (distance <= width) {
+      bends.emplace_back(record.node_id, distance);
+    }
+  }
+  std::sort(bends.begin(), bends.end());
+  return bends;
+}
+
+/// @brief Expect the same bends with the same distances from the index and
+/// from a scan
+/// @return Number of bends found
+auto expect_same_corridor(const ntask::BendIndex &index,
+                          const std::vector<ntask::RoutePoint> &route,
+                          double width) -> std::size_t {
+  constexpr double MAX_ERROR = 1e-6;
+  const auto found = query_corridor(index, route, width);
+  const auto scanned = scan_corridor(index, route, width);
+  EXPECT_EQ(found.size(), scanned.size()) << "width " << width;
+  for (std::size_t bend = 0; bend < std::min(found.size(), scanned.size());
+       ++bend) {
+    EXPECT_EQ(found[bend].first, scanned[bend].first);
+    EXPECT_NEAR(found[bend].second, scanned[bend].second, MAX_ERROR);
+  }
+  return found.size();
+}
+
+// Routes winding through the bends find what a scan finds, each bend once
+// with its distance to the closest segment
+TEST_F(BendIndexTest, QueriesCorridorLikeScan) {
+  const auto index = make_index(spread_locations(BEND_COUNT, 9, 49, 11, 51));
+  const std::vector<ntask::RoutePoint> route{
+      {.lon = 9.2, .lat = 49.1}, {.lon = 9.6, .lat = 50.8},
+      {.lon = 10.0, .lat = 49.2}, {.lon = 10.4, .lat = 50.9},
+      {.lon = 10.4, .lat = 50.9}, {.lon = 10.9, .lat = 49.5},
+      {.lon = 9.5, .lat = 49.6}};
+  for (const auto width : {100.0, 1000.0, 5000.0}) {
+    expect_same_corridor(index, route, width);
+  }
+  EXPECT_GT(expect_same_corridor(index, route, 1000), 0U);
+
+  // A route of one point finds the bends around it
+  EXPECT_GT(expect_same_corridor(index, {{.lon = 10, .lat = 50}}, 5000), 0U);
+  EXPECT_TRUE(index.query_corridor({}, 5000).empty());
+}
+
+// A bend close to a vertex is found by both segments and kept once, with the
+// distance to the closer one
+TEST_F(BendIndexTest, KeepsCorridorBendOnceAtVertex) {
+  const auto index = make_index({osmium::Location{10.0103, 49.9998}});
+  const std::vector<ntask::RoutePoint> route{{.lon = 10, .lat = 50},
+                                             {.lon = 10.01, .lat = 50},
+                                             {.lon = 10.01, .lat = 50.01}};
+  const auto bends = index.query_corridor(route, 50);
+  ASSERT_EQ(bends.size(), 1U);
+  const auto &record = *bends[0].record;
+  EXPECT_DOUBLE_EQ(bends[0].distance,
+                   std::min(get_segment_distance(route[0], route[1], record),
+                            get_segment_distance(route[1], route[2], record)));
+  EXPECT_EQ(expect_same_corridor(index, route, 50), 1U);
+}
+
+// Routes crossing the antimeridian find the bends on both sides of it
+TEST_F(BendIndexTest, QueriesCorridorAcrossAntimeridian) {
+  const auto index =
+      make_index(spread_locations(BEND_COUNT, 179.5, -1, 180.5, 1));
+  const std::vector<ntask::RoutePoint> route{{.lon = 179.7, .lat = -0.5},
+                                             {.lon = -179.8, .lat = 0.5},
+                                             {.lon = 179.9, .lat = 0.8}};
+  for (const auto width : {100.0, 1000.0, 5000.0}) {
+    expect_same_corridor(index, route, width);
+  }
+  EXPECT_GT(expect_same_corridor(index, route, 1000), 0U);
+}
+
+}  // namespace
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <osmium/osm/node_ref.hpp>
+
+#include "bend_detector.hpp"
+#include "bend_set.hpp"
+
+namespace {
+
+/// @return Bend at node @p node_id found in way @p way_id
+auto make_bend(osmium::object_id_type node_id, osmium::object_id_type way_id,
+               double min_angle) -> ntask::BendDetector::Bend {
+  return ntask::BendDetector::Bend{
+      .node = osmium::NodeRef{node_id, {10.0, 50.0}},
+      .profile = 0,
+      .min_angle = min_angle,
+      .way_id = way_id};
+}
+
+// Each way meeting at a node counts once, also a way passing it twice
+TEST(BendSetTest, CountsDistinctWays) {
+  ntask::BendSet set;
+  EXPECT_TRUE(set.add(make_bend(1, 10, 120)));
+  EXPECT_TRUE(set.add(make_bend(2, 10, 130)));
+  // Way 10 is closed, its first and last node is node 1
+  EXPECT_FALSE(set.add(make_bend(1, 10, 110)));
+  EXPECT_FALSE(set.add(make_bend(1, 11, 100)));
+  EXPECT_FALSE(set.add(make_bend(2, 12, 125)));
+  EXPECT_FALSE(set.add(make_bend(2, 12, 125)));
+
+  const auto entries = set.get_entries();
+  ASSERT_EQ(entries.size(), 2U);
+  EXPECT_EQ(set.get_added_count(), 6U);
+  EXPECT_EQ(entries[0].node.ref(), 1);
+  EXPECT_EQ(entries[0].way_id, 10);
+  EXPECT_EQ(entries[0].way_count, 2U);
+  EXPECT_FLOAT_EQ(entries[0].min_angle, 100);
+  EXPECT_EQ(entries[1].node.ref(), 2);
+  EXPECT_EQ(entries[1].way_count, 2U);
+  EXPECT_FLOAT_EQ(entries[1].min_angle, 125);
+}
+
+}  // namespace
@@ -0,0 +1,187 @@
+#include <gtest/gtest.h>
+
+#include <osmium/builder/attr.hpp>
+#include <osmium/memory/buffer.hpp>
+#include <osmium/osm/node.hpp>
+#include <osmium/osm/way.hpp>
+#include <set>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "bend_state.hpp"
+#include "boundary.hpp"
+#include "way_filter.hpp"
+
+namespace {
+
+constexpr std::size_t BUFFER_SIZE = 1024;
+
+/// @brief Thresholds of the default configuration
+constexpr double DISTANCE_THRESHOLD = 50;
+constexpr double ANGLE_THRESHOLD = 135;
+
+/// @brief State of primary roads with the default thresholds, updated by
+/// objects built as in a change file
+class BendStateUpdaterTest : public ::testing::Test {
+ protected:
+  /// @return Version 2 of a node at another location
+  auto make_node(osmium::object_id_type id, double lon, double lat)
+      -> const osmium::Node & {
+    namespace attr = osmium::builder::attr;
+    const auto offset = osmium::builder::add_node(
+        buffer, attr::_id(id), attr::_version(2), attr::_location(lon, lat));
+    return buffer.get<osmium::Node>(offset);
+  }
+
+  /// @return Version 2 of a primary road through @p node_ids
+  auto make_way(osmium::object_id_type id,
+                std::initializer_list<osmium::object_id_type> node_ids)
+      -> const osmium::Way & {
+    namespace attr = osmium::builder::attr;
+    const auto offset = osmium::builder::add_way(
+        buffer, attr::_id(id), attr::_version(2),
+        attr::_tag("highway", "primary"), attr::_nodes(node_ids));
+    return buffer.get<osmium::Way>(offset);
+  }
+
+  /// @brief Add way 1, turning back at node 2, with its bends to the state
+  void add_bent_way() {
+    ntask::BendState::WayState way_state{
+        .profiles = 1,
+        .nodes = {osmium::NodeRef{1, {10.0, 50.0}},
+                  osmium::NodeRef{2, {10.0002, 50.0001}},
+                  osmium::NodeRef{3, {10.0, 50.0002}}},
+        .bends = {}};
+    detector.detect(way_state.nodes, way_state.profiles, way_state.bends);
+    for (auto &bend : way_state.bends) {
+      bend.way_id = 1;
+    }
+    state.set_way(1, std::move(way_state));
+  }
+
+  const std::vector<ntask::FilterRules> filter_rules{
+      ntask::FilterRules{.highway_tags = {"primary"}, .blacklisted_tags = {}}};
+  const std::vector<ntask::BendDetector::Thresholds> thresholds{
+      ntask::BendDetector::Thresholds{.distance_threshold = DISTANCE_THRESHOLD,
+                                      .angle_threshold = ANGLE_THRESHOLD}};
+  const ntask::WayFilter way_filter{filter_rules};
+  ntask::BendDetector detector{thresholds,
+                               ntask::BendDetector::DistanceModel::haversine};
+  ntask::BendState state{ntask::BendState::Key::make(
+      filter_rules, thresholds, ntask::BendDetector::DistanceModel::haversine,
+      0)};
+  osmium::memory::Buffer buffer{BUFFER_SIZE,
+                                osmium::memory::Buffer::auto_grow::yes};
+};
+
+// A way only touched by a moved node is scanned again with its stored nodes,
+// none of the others is in the change file
+TEST_F(BendStateUpdaterTest, RescansWayWithMovedNode) {
+  // A straight way, about 11 m between its nodes
+  state.set_way(1, ntask::BendState::WayState{
+                       .profiles = 1,
+                       .nodes = {osmium::NodeRef{1, {10.0, 50.0}},
+                                 osmium::NodeRef{2, {10.0, 50.0001}},
+                                 osmium::NodeRef{3, {10.0, 50.0002}}},
+                       .bends = {}});
+
+  // Node 2 moves aside, the way turns back at it
+  ntask::BendStateUpdater updater{state, way_filter, detector};
+  updater.node(make_node(2, 10.0002, 50.0001));
+  const auto bend_changes = updater.apply();
+
+  EXPECT_EQ(updater.get_updated_way_count(), 1U);
+  EXPECT_EQ(updater.get_unresolved_way_count(), 0U);
+  ASSERT_EQ(state.get_ways().size(), 1U);
+  const auto &way_state = state.get_ways().at(1);
+  ASSERT_EQ(way_state.nodes.size(), 3U);
+  EXPECT_EQ(way_state.nodes[1].location(), osmium::Location(10.0002, 50.0001));
+  ASSERT_EQ(way_state.bends.size(), 1U);
+  EXPECT_EQ(way_state.bends[0].node.ref(), 2);
+  ASSERT_EQ(bend_changes.size(), 1U);
+  EXPECT_EQ(bend_changes[0].node.ref(), 2);
+  EXPECT_TRUE(bend_changes[0].added);
+}
+
+// A node still found after moving is reported as removed at its old location
+// and added at the new one
+TEST_F(BendStateUpdaterTest, ReportsMovedBend) {
+  add_bent_way();
+  ntask::BendStateUpdater updater{state, way_filter, detector};
+  updater.node(make_node(2, 10.00021, 50.0001));
+  const auto bend_changes = updater.apply();
+
+  ASSERT_EQ(bend_changes.size(), 2U);
+  EXPECT_EQ(bend_changes[0].node.ref(), 2);
+  EXPECT_FALSE(bend_changes[0].added);
+  EXPECT_EQ(bend_changes[0].node.location(),
+            osmium::Location(10.0002, 50.0001));
+  EXPECT_EQ(bend_changes[1].node.ref(), 2);
+  EXPECT_TRUE(bend_changes[1].added);
+  EXPECT_EQ(bend_changes[1].node.location(),
+            osmium::Location(10.00021, 50.0001));
+}
+
+// A changed way with a node of unknown location keeps its previous version
+// and bends without reporting any change, until a later update resolves it
+TEST_F(BendStateUpdaterTest, KeepsWayWithUnresolvedNode) {
+  add_bent_way();
+  const auto previous_way = state.get_ways().at(1);
+  ASSERT_EQ(previous_way.bends.size(), 1U);
+
+  ntask::BendStateUpdater updater{state, way_filter, detector};
+  updater.way(make_way(1, {1, 2, 3, 4}));
+  EXPECT_TRUE(updater.apply().empty());
+  EXPECT_EQ(updater.get_updated_way_count(), 0U);
+  EXPECT_EQ(updater.get_unresolved_way_count(), 1U);
+  ASSERT_EQ(state.get_ways().size(), 1U);
+  EXPECT_EQ(state.get_ways().at(1).nodes, previous_way.nodes);
+  EXPECT_EQ(state.get_ways().at(1).bends.size(), 1U);
+  EXPECT_EQ(state.get_stale_ways(), std::set<osmium::object_id_type>{1});
+
+  // Node 4, without a sharp turn at node 3, comes with the next change of the
+  // way
+  updater.node(make_node(4, 9.99991, 50.0003));
+  updater.way(make_way(1, {1, 2, 3, 4}));
+  EXPECT_TRUE(updater.apply().empty());
+  EXPECT_EQ(state.get_ways().at(1).nodes.size(), 4U);
+  EXPECT_TRUE(state.get_stale_ways().empty());
+}
+
+// A new way with a node of unknown location is not added, only marked as
+// stale
+TEST_F(BendStateUpdaterTest, MarksNewUnresolvedWayStale) {
+  ntask::BendStateUpdater updater{state, way_filter, detector};
+  updater.node(make_node(6, 10.0, 50.0));
+  updater.way(make_way(5, {6, 7}));
+  EXPECT_TRUE(updater.apply().empty());
+  EXPECT_EQ(updater.get_unresolved_way_count(), 1U);
+  EXPECT_TRUE(state.get_ways().empty());
+  EXPECT_EQ(state.get_stale_ways(), std::set<osmium::object_id_type>{5});
+}
+
+// A node moved out of the boundary loses its location as in a full run, and
+// a new way entirely outside is left out
+TEST_F(BendStateUpdaterTest, DropsLocationsOutsideBoundary) {
+  add_bent_way();
+  const auto boundary = ntask::Boundary::from_box(
+      osmium::Location{9.9, 49.9}, osmium::Location{10.00025, 50.1});
+  ntask::BendStateUpdater updater{state, way_filter, detector, &boundary};
+  updater.node(make_node(2, 10.0003, 50.0001));
+  updater.node(make_node(6, 10.0003, 50.0));
+  updater.node(make_node(7, 10.0004, 50.0));
+  updater.way(make_way(5, {6, 7}));
+  const auto bend_changes = updater.apply();
+
+  ASSERT_EQ(state.get_ways().size(), 1U);
+  const auto &way_state = state.get_ways().at(1);
+  ASSERT_EQ(way_state.nodes.size(), 3U);
+  EXPECT_FALSE(way_state.nodes[1].location().valid());
+  EXPECT_TRUE(way_state.bends.empty());
+  ASSERT_EQ(bend_changes.size(), 1U);
+  EXPECT_EQ(bend_changes[0].node.ref(), 2);
+  EXPECT_FALSE(bend_changes[0].added);
+  EXPECT_TRUE(state.get_stale_ways().empty());
+}
+
+}  // namespace
@@ -0,0 +1,38 @@
+#include <gtest/gtest.h>
+
+#include <osmium/osm/location.hpp>
+
+#include "boundary.hpp"
+
+namespace {
+
+// Nodes on any edge of a box are inside
+TEST(BoundaryTest, BoxContainsEdges) {
+  const auto boundary = ntask::Boundary::from_box(osmium::Location{1.0, 2.0},
+                                                  osmium::Location{3.0, 4.0});
+  EXPECT_TRUE(boundary.contains(osmium::Location{2.0, 3.0}));
+  EXPECT_TRUE(boundary.contains(osmium::Location{1.0, 3.0}));
+  EXPECT_TRUE(boundary.contains(osmium::Location{3.0, 3.0}));
+  EXPECT_TRUE(boundary.contains(osmium::Location{2.0, 2.0}));
+  EXPECT_TRUE(boundary.contains(osmium::Location{2.0, 4.0}));
+  EXPECT_TRUE(boundary.contains(osmium::Location{1.0, 2.0}));
+  EXPECT_TRUE(boundary.contains(osmium::Location{3.0, 4.0}));
+
+  EXPECT_FALSE(boundary.contains(osmium::Location{3.0000001, 3.0}));
+  EXPECT_FALSE(boundary.contains(osmium::Location{2.0, 4.0000001}));
+  EXPECT_FALSE(boundary.contains(osmium::Location{0.9999999, 3.0}));
+  EXPECT_FALSE(boundary.contains(osmium::Location{2.0, 1.9999999}));
+  EXPECT_FALSE(boundary.contains(osmium::Location{}));
+}
+
+// A polygon covering the same area is a different boundary
+TEST(BoundaryTest, BoxHashDiffersFromRing) {
+  const osmium::Location bottom_left{1.0, 2.0};
+  const osmium::Location top_right{3.0, 4.0};
+  const ntask::Boundary ring{{{bottom_left, osmium::Location{3.0, 2.0},
+                               top_right, osmium::Location{1.0, 4.0}}}};
+  EXPECT_NE(ntask::Boundary::from_box(bottom_left, top_right).get_hash(),
+            ring.get_hash());
+}
+
+}  // namespace
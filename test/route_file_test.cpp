@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "route_file.hpp"
+
+namespace {
+
+/// @brief Route file written to a temporary file, removed after each test
+class RouteFileTest : public ::testing::Test {
+ protected:
+  ~RouteFileTest() override {
+    for (const auto &path : written_paths) {
+      std::filesystem::remove(path);
+    }
+  }
+
+  /// @return Path of the route file of the test with @p suffix
+  static auto get_path(const std::string &suffix) -> std::string {
+    return (std::filesystem::temp_directory_path() /
+            ("ntask_route_file_test_" +
+             std::string{::testing::UnitTest::GetInstance()
+                             ->current_test_info()
+                             ->name()} +
+             suffix))
+        .string();
+  }
+
+  /// @brief Write @p content to the route file with @p suffix
+  /// @return Path of the file
+  auto write(const std::string &suffix, const std::string &content)
+      -> std::string {
+    const auto path = get_path(suffix);
+    std::ofstream{path} << content;
+    written_paths.push_back(path);
+    return path;
+  }
+
+ private:
+  std::vector<std::string> written_paths;
+};
+
+// Every track segment and route is a route, named after its track even if
+// the name comes last
+TEST_F(RouteFileTest, ReadsGpxTracksAndRoutes) {
+  const auto routes = ntask::read_routes(write(".gpx", R"(<?xml version="1.0"?>
+<gpx version="1.1">
+  <trk>
+    <trkseg>
+      <trkpt lat="50.1" lon="10.2"><ele>100</ele><name>Start</name></trkpt>
+      <trkpt lon="10.3" lat="50.2"/>
+    </trkseg>
+    <trkseg>
+      <trkpt lat=" 50.3 " lon="-10.4"/>
+    </trkseg>
+    <name>Pass road</name>
+  </trk>
+  <rte>
+    <name>Coast road</name>
+    <rtept lat="-33.5" lon="151.25"/>
+  </rte>
+</gpx>
+)"));
+
+  ASSERT_EQ(routes.size(), 3U);
+  EXPECT_EQ(routes[0].name, "Pass road");
+  ASSERT_EQ(routes[0].points.size(), 2U);
+  EXPECT_DOUBLE_EQ(routes[0].points[0].lon, 10.2);
+  EXPECT_DOUBLE_EQ(routes[0].points[0].lat, 50.1);
+  EXPECT_DOUBLE_EQ(routes[0].points[1].lon, 10.3);
+  EXPECT_DOUBLE_EQ(routes[0].points[1].lat, 50.2);
+  EXPECT_EQ(routes[1].name, "Pass road");
+  ASSERT_EQ(routes[1].points.size(), 1U);
+  EXPECT_DOUBLE_EQ(routes[1].points[0].lon, -10.4);
+  EXPECT_DOUBLE_EQ(routes[1].points[0].lat, 50.3);
+  EXPECT_EQ(routes[2].name, "Coast road");
+  ASSERT_EQ(routes[2].points.size(), 1U);
+  EXPECT_DOUBLE_EQ(routes[2].points[0].lon, 151.25);
+  EXPECT_DOUBLE_EQ(routes[2].points[0].lat, -33.5);
+  EXPECT_FALSE(routes[0].width);
+}
+
+// A point without a number for lat or lon fails the file instead of being
+// placed at 0
+TEST_F(RouteFileTest, RejectsGpxPointWithoutLatOrLon) {
+  for (const auto *point :
+       {R"(<trkpt lat="50.1"/>)", R"(<trkpt lon="10.2"/>)", R"(<trkpt/>)",
+        R"(<trkpt lat="north" lon="10.2"/>)",
+        R"(<trkpt lat="50.1" lon="10.2 east"/>)",
+        R"(<trkpt lat="" lon="10.2"/>)"}) {
+    const auto path = write(".gpx", std::string{"<gpx><trk><trkseg>"} + point +
+                                        "</trkseg></trk></gpx>");
+    EXPECT_THROW(ntask::read_routes(path), std::runtime_error) << point;
+  }
+}
+
+// Points belong to a track segment or a route
+TEST_F(RouteFileTest, RejectsGpxPointOutsideRoute) {
+  EXPECT_THROW(ntask::read_routes(write(
+                   ".gpx", R"(<gpx><trkpt lat="50.1" lon="10.2"/></gpx>)")),
+               std::runtime_error);
+}
+
+// Every line of a GeoJSON file is a route, with the name and width of its
+// feature; other geometries are left out
+TEST_F(RouteFileTest, ReadsGeoJsonLines) {
+  const auto routes = ntask::read_routes(write(".geojson", R"({
+  "type": "FeatureCollection",
+  "features": [
+    {"type": "Feature", "properties": {"name": "Pass road", "width": 40},
+     "geometry": {"type": "LineString",
+                  "coordinates": [[10.2, 50.1], [10.3, 50.2, 812]]}},
+    {"type": "Feature", "properties": null,
+     "geometry": {"type": "MultiLineString",
+                  "coordinates": [[[1, 2], [3, 4]], [[5, 6]]]}},
+    {"type": "Feature", "properties": {"name": "Summit"},
+     "geometry": {"type": "Point", "coordinates": [10.4, 50.3]}},
+    {"type": "Feature", "properties": {"name": "Loop"},
+     "geometry": {"type": "GeometryCollection", "geometries": [
+       {"type": "LineString", "coordinates": [[-1.5, -2.5]]}]}}
+  ]
+})"));
+
+  ASSERT_EQ(routes.size(), 4U);
+  EXPECT_EQ(routes[0].name, "Pass road");
+  ASSERT_TRUE(routes[0].width);
+  EXPECT_DOUBLE_EQ(*routes[0].width, 40);
+  ASSERT_EQ(routes[0].points.size(), 2U);
+  EXPECT_DOUBLE_EQ(routes[0].points[1].lon, 10.3);
+  EXPECT_DOUBLE_EQ(routes[0].points[1].lat, 50.2);
+  EXPECT_EQ(routes[1].name, "");
+  EXPECT_FALSE(routes[1].width);
+  ASSERT_EQ(routes[1].points.size(), 2U);
+  EXPECT_DOUBLE_EQ(routes[1].points[1].lon, 3);
+  EXPECT_DOUBLE_EQ(routes[1].points[1].lat, 4);
+  ASSERT_EQ(routes[2].points.size(), 1U);
+  EXPECT_DOUBLE_EQ(routes[2].points[0].lon, 5);
+  EXPECT_EQ(routes[3].name, "Loop");
+  ASSERT_EQ(routes[3].points.size(), 1U);
+  EXPECT_DOUBLE_EQ(routes[3].points[0].lat, -2.5);
+}
+
+// A position without a latitude fails the file
+TEST_F(RouteFileTest, RejectsGeoJsonPositionWithoutLat) {
+  EXPECT_THROW(ntask::read_routes(write(".geojson", R"({
+  "type": "LineString", "coordinates": [[10.2, 50.1], [10.3]]
+})")),
+               std::exception);
+}
+
+// A missing file fails with its path
+TEST_F(RouteFileTest, RejectsMissingFile) {
+  EXPECT_THROW(ntask::read_routes(get_path(".gpx")), std::runtime_error);
+}
+
+}  // namespace
@@ -0,0 +1,42 @@
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <numbers>
+#include <osmium/geom/haversine.hpp>
+#include <osmium/osm/location.hpp>
+#include <osmium/osm/node_ref.hpp>
+#include <vector>
+
+#include "way_simplifier.hpp"
+
+namespace {
+
+constexpr double TOLERANCE = 0.5;
+
+/// @return Way from @p from_lat to @p to_lat along the prime meridian, its
+/// middle node @p offset meters to the east
+auto make_meridian_way(double from_lat, double to_lat, double offset)
+    -> std::vector<osmium::NodeRef> {
+  const auto middle_lat = (from_lat + to_lat) / 2;
+  const auto middle_lon =
+      offset / (osmium::geom::haversine::EARTH_RADIUS_IN_METERS *
+                std::numbers::pi / 180 *
+                std::cos(middle_lat * std::numbers::pi / 180));
+  return {osmium::NodeRef{1, osmium::Location{0.0, from_lat}},
+          osmium::NodeRef{2, osmium::Location{middle_lon, middle_lat}},
+          osmium::NodeRef{3, osmium::Location{0.0, to_lat}}};
+}
+
+// The distance of a node is measured at its own latitude, not at the one of
+// the first node of a long way
+TEST(WaySimplifierTest, MeasuresNodeAtItsLatitude) {
+  ntask::WaySimplifier simplifier{TOLERANCE};
+
+  const auto southward = make_meridian_way(70, 60, 0.6);
+  EXPECT_EQ(simplifier.simplify(southward).size(), 3U);
+
+  const auto northward = make_meridian_way(60, 70, 0.45);
+  EXPECT_EQ(simplifier.simplify(northward).size(), 2U);
+}
+
+}  // namespace
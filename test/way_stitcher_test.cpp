@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <osmium/osm/node_ref.hpp>
+#include <vector>
+
+#include "bend_detector.hpp"
+#include "way_stitcher.hpp"
+
+namespace {
+
+/// @brief Thresholds of the default configuration
+constexpr double DISTANCE_THRESHOLD = 50;
+constexpr double ANGLE_THRESHOLD = 135;
+
+constexpr std::size_t MAX_ENDPOINTS = 16;
+
+/// @brief Node all ways of the test end at
+constexpr osmium::object_id_type SHARED_NODE = 100;
+
+// Two roads ending at the same node both wait for their continuing way
+TEST(WayStitcherTest, StitchesRoadsEndingAtOneNode) {
+  ntask::WayStitcher stitcher{
+      {ntask::BendDetector::Thresholds{.distance_threshold = DISTANCE_THRESHOLD,
+                                       .angle_threshold = ANGLE_THRESHOLD}},
+      ntask::BendDetector::DistanceModel::haversine,
+      MAX_ENDPOINTS};
+  constexpr std::uint64_t FIRST_ROAD = 1;
+  constexpr std::uint64_t SECOND_ROAD = 2;
+  const osmium::Location shared{10.0, 50.0002};
+  std::vector<ntask::BendDetector::Bend> bends;
+
+  // The first road comes from the south, the second from the west, about
+  // 11 m between nodes
+  const std::vector<osmium::NodeRef> first{
+      {1, {10.0, 50.0}}, {2, {10.0, 50.0001}}, {SHARED_NODE, shared}};
+  const std::vector<osmium::NodeRef> second{
+      {3, {9.9997, 50.0002}}, {4, {9.99985, 50.0002}}, {SHARED_NODE, shared}};
+  stitcher.add(11, first, 1, FIRST_ROAD, bends);
+  stitcher.add(12, second, 1, SECOND_ROAD, bends);
+
+  // The first road turns back to the south-east, the second goes on east
+  const std::vector<osmium::NodeRef> first_continued{
+      {SHARED_NODE, shared}, {5, {10.0002, 50.0001}}, {6, {10.0004, 50.0}}};
+  const std::vector<osmium::NodeRef> second_continued{
+      {SHARED_NODE, shared}, {7, {10.00015, 50.0002}}, {8, {10.0003, 50.0002}}};
+  stitcher.add(21, first_continued, 1, FIRST_ROAD, bends);
+  stitcher.add(22, second_continued, 1, SECOND_ROAD, bends);
+
+  const auto &counters = stitcher.get_counters();
+  EXPECT_EQ(counters.junction_count, 2U);
+  EXPECT_EQ(counters.dropped_count, 0U);
+  ASSERT_EQ(bends.size(), 1U);
+  EXPECT_EQ(bends[0].node.ref(), SHARED_NODE);
+  EXPECT_EQ(bends[0].way_id, 21);
+}
+
+// An end of the same road meeting a waiting end without a common profile is
+// counted as dropped
+TEST(WayStitcherTest, CountsEndWithoutCommonProfile) {
+  ntask::WayStitcher stitcher{
+      {ntask::BendDetector::Thresholds{.distance_threshold = DISTANCE_THRESHOLD,
+                                       .angle_threshold = ANGLE_THRESHOLD},
+       ntask::BendDetector::Thresholds{.distance_threshold = DISTANCE_THRESHOLD,
+                                       .angle_threshold = ANGLE_THRESHOLD}},
+      ntask::BendDetector::DistanceModel::haversine,
+      MAX_ENDPOINTS};
+  constexpr std::uint64_t ROAD = 1;
+  const osmium::Location shared{10.0, 50.0002};
+  std::vector<ntask::BendDetector::Bend> bends;
+  const std::vector<osmium::NodeRef> first{
+      {1, {10.0, 50.0}}, {2, {10.0, 50.0001}}, {SHARED_NODE, shared}};
+  const std::vector<osmium::NodeRef> continued{
+      {SHARED_NODE, shared}, {3, {10.0, 50.0003}}, {4, {10.0, 50.0004}}};
+  stitcher.add(11, first, 1, ROAD, bends);
+  stitcher.add(12, continued, 2, ROAD, bends);
+
+  EXPECT_EQ(stitcher.get_counters().junction_count, 0U);
+  EXPECT_EQ(stitcher.get_counters().dropped_count, 1U);
+}
+
+}  // namespace